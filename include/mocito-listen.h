@@ -0,0 +1,39 @@
+/*
+   Mocito is a mocking library for writing unit tests of C code.
+   Copyright (C) 2025, Carlos Rica Espinosa <jasampler@gmail.com>
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software Foundation,
+   Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+*/
+
+/**
+ * \file mocito-listen.h
+ * Header file of the listener of commands of src/mocito-listen.c, which
+ * depends on POSIX threads and sockets unlike the rest of Mocito.
+ */
+
+#ifndef MOCITO_LISTEN_H
+#define MOCITO_LISTEN_H
+
+/**
+ * Starts listening for commands on a Unix socket at the given path,
+ * returning 0 or -1 if the socket or the thread cannot be created.
+ * Each line received is executed by moc_command() before the next call
+ * to a mock, replacing the poll function, and is answered with "ok" or
+ * "error: " and the message. The memory for the strings of the commands
+ * must be given with moc_init_store().
+ */
+int moc_listen(const char *path);
+
+#endif /* MOCITO_LISTEN_H */
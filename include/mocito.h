@@ -25,6 +25,8 @@
 #ifndef MOCITO_H
 #define MOCITO_H
 
+#include <stdarg.h>
+
 /**
  * Initializes the given memory block to store the mocking-related data.
  */
@@ -60,6 +62,11 @@ typedef void (*moc_errfn_t)(void);
  */
 void moc_set_errfn(moc_errfn_t errfn);
 
+/**
+ * Returns the function that is called when an error is detected.
+ */
+moc_errfn_t moc_get_errfn(void);
+
 /**
  * Generic function pointer type for storing a pointer to any function.
  */
@@ -83,11 +90,64 @@ typedef int moc_bool;
 #define moc_false 0
 #define moc_true (!moc_false)
 
+/**
+ * Returns moc_true if the last error was reported because no mapping
+ * matched a call, so that an error function can let the call continue.
+ */
+moc_bool moc_err_nomatch(void);
+
 /**
  * Type of the identifiers of the supported data types.
  */
 typedef unsigned char moc_type;
 
+/**
+ * Constants of the types returned by the type functions, for using them
+ * where a constant is needed, like in the switch cases.
+ */
+#define MOC_TYPE_VOID 0
+#define MOC_TYPE_C 4
+#define MOC_TYPE_S 8
+#define MOC_TYPE_I 12
+#define MOC_TYPE_L 16
+#define MOC_TYPE_F 20
+#define MOC_TYPE_D 24
+#define MOC_TYPE_SC 28
+#define MOC_TYPE_UC 32
+#define MOC_TYPE_US 36
+#define MOC_TYPE_UI 40
+#define MOC_TYPE_UL 44
+#define MOC_TYPE_FN 48
+#define MOC_TYPE_ST 52
+
+#define MOC_TYPE_P 1
+#define MOC_TYPE_P_C 5
+#define MOC_TYPE_P_S 9
+#define MOC_TYPE_P_I 13
+#define MOC_TYPE_P_L 17
+#define MOC_TYPE_P_F 21
+#define MOC_TYPE_P_D 25
+#define MOC_TYPE_P_SC 29
+#define MOC_TYPE_P_UC 33
+#define MOC_TYPE_P_US 37
+#define MOC_TYPE_P_UI 41
+#define MOC_TYPE_P_UL 45
+#define MOC_TYPE_P_FN 49
+
+#define MOC_TYPE_CP 2
+#define MOC_TYPE_CP_C 6
+#define MOC_TYPE_CP_S 10
+#define MOC_TYPE_CP_I 14
+#define MOC_TYPE_CP_L 18
+#define MOC_TYPE_CP_F 22
+#define MOC_TYPE_CP_D 26
+#define MOC_TYPE_CP_SC 30
+#define MOC_TYPE_CP_UC 34
+#define MOC_TYPE_CP_US 38
+#define MOC_TYPE_CP_UI 42
+#define MOC_TYPE_CP_UL 46
+#define MOC_TYPE_CP_FN 50
+
 /**
  * Structure to store any value of a basic type including its type.
  */
@@ -95,6 +155,174 @@ struct moc_value {
 	double opaque[2];
 };
 
+/*
+ * Defining MOC_INLINE before including this header replaces the next
+ * functions with inline definitions when the compiler supports them,
+ * so that converting the values does not need calls to the library.
+ */
+#if defined(MOC_INLINE) && defined(__GNUC__)
+#define MOC_INLINE_FN static __inline__
+#elif defined(MOC_INLINE) && defined(__STDC_VERSION__) \
+	&& __STDC_VERSION__ >= 199901L
+#define MOC_INLINE_FN static inline
+#endif
+
+#ifdef MOC_INLINE_FN
+
+/* The data of the values is followed by their type, and the data is
+ * accessed through unions for the compilers with strict aliasing: */
+#define MOC_INLINE_TYPE(value) \
+	(*(moc_type *) (void *) ((value).opaque + 1))
+#define MOC_INLINE_TYPEFN(name, type) \
+	MOC_INLINE_FN moc_type name(void) { \
+		return (moc_type) (type); \
+	}
+#define MOC_INLINE_VALFN(name, ctype, type) \
+	MOC_INLINE_FN struct moc_value name(ctype val) { \
+		union { struct moc_value value; ctype data; } u; \
+		u.value.opaque[0] = u.value.opaque[1] = 0; \
+		u.data = val; \
+		MOC_INLINE_TYPE(u.value) = (moc_type) (type); \
+		return u.value; \
+	}
+#define MOC_INLINE_GETFN(name, ctype) \
+	MOC_INLINE_FN ctype name(struct moc_value value) { \
+		union { struct moc_value value; ctype data; } u; \
+		u.value = value; \
+		return u.data; \
+	}
+
+MOC_INLINE_TYPEFN(moc_type_void, MOC_TYPE_VOID)
+MOC_INLINE_TYPEFN(moc_type_c, MOC_TYPE_C)
+MOC_INLINE_TYPEFN(moc_type_s, MOC_TYPE_S)
+MOC_INLINE_TYPEFN(moc_type_i, MOC_TYPE_I)
+MOC_INLINE_TYPEFN(moc_type_l, MOC_TYPE_L)
+MOC_INLINE_TYPEFN(moc_type_f, MOC_TYPE_F)
+MOC_INLINE_TYPEFN(moc_type_d, MOC_TYPE_D)
+MOC_INLINE_TYPEFN(moc_type_sc, MOC_TYPE_SC)
+MOC_INLINE_TYPEFN(moc_type_uc, MOC_TYPE_UC)
+MOC_INLINE_TYPEFN(moc_type_us, MOC_TYPE_US)
+MOC_INLINE_TYPEFN(moc_type_ui, MOC_TYPE_UI)
+MOC_INLINE_TYPEFN(moc_type_ul, MOC_TYPE_UL)
+MOC_INLINE_TYPEFN(moc_type_fn, MOC_TYPE_FN)
+
+MOC_INLINE_TYPEFN(moc_type_p, MOC_TYPE_P)
+MOC_INLINE_TYPEFN(moc_type_p_c, MOC_TYPE_P_C)
+MOC_INLINE_TYPEFN(moc_type_p_s, MOC_TYPE_P_S)
+MOC_INLINE_TYPEFN(moc_type_p_i, MOC_TYPE_P_I)
+MOC_INLINE_TYPEFN(moc_type_p_l, MOC_TYPE_P_L)
+MOC_INLINE_TYPEFN(moc_type_p_f, MOC_TYPE_P_F)
+MOC_INLINE_TYPEFN(moc_type_p_d, MOC_TYPE_P_D)
+MOC_INLINE_TYPEFN(moc_type_p_sc, MOC_TYPE_P_SC)
+MOC_INLINE_TYPEFN(moc_type_p_uc, MOC_TYPE_P_UC)
+MOC_INLINE_TYPEFN(moc_type_p_us, MOC_TYPE_P_US)
+MOC_INLINE_TYPEFN(moc_type_p_ui, MOC_TYPE_P_UI)
+MOC_INLINE_TYPEFN(moc_type_p_ul, MOC_TYPE_P_UL)
+MOC_INLINE_TYPEFN(moc_type_p_fn, MOC_TYPE_P_FN)
+
+MOC_INLINE_TYPEFN(moc_type_cp, MOC_TYPE_CP)
+MOC_INLINE_TYPEFN(moc_type_cp_c, MOC_TYPE_CP_C)
+MOC_INLINE_TYPEFN(moc_type_cp_s, MOC_TYPE_CP_S)
+MOC_INLINE_TYPEFN(moc_type_cp_i, MOC_TYPE_CP_I)
+MOC_INLINE_TYPEFN(moc_type_cp_l, MOC_TYPE_CP_L)
+MOC_INLINE_TYPEFN(moc_type_cp_f, MOC_TYPE_CP_F)
+MOC_INLINE_TYPEFN(moc_type_cp_d, MOC_TYPE_CP_D)
+MOC_INLINE_TYPEFN(moc_type_cp_sc, MOC_TYPE_CP_SC)
+MOC_INLINE_TYPEFN(moc_type_cp_uc, MOC_TYPE_CP_UC)
+MOC_INLINE_TYPEFN(moc_type_cp_us, MOC_TYPE_CP_US)
+MOC_INLINE_TYPEFN(moc_type_cp_ui, MOC_TYPE_CP_UI)
+MOC_INLINE_TYPEFN(moc_type_cp_ul, MOC_TYPE_CP_UL)
+MOC_INLINE_TYPEFN(moc_type_cp_fn, MOC_TYPE_CP_FN)
+
+MOC_INLINE_FN struct moc_value moc_void(void) {
+	struct moc_value value;
+	value.opaque[0] = value.opaque[1] = 0;
+	return value;
+}
+MOC_INLINE_VALFN(moc_c, char, MOC_TYPE_C)
+MOC_INLINE_VALFN(moc_s, short, MOC_TYPE_S)
+MOC_INLINE_VALFN(moc_i, int, MOC_TYPE_I)
+MOC_INLINE_VALFN(moc_l, long, MOC_TYPE_L)
+MOC_INLINE_VALFN(moc_f, float, MOC_TYPE_F)
+MOC_INLINE_VALFN(moc_d, double, MOC_TYPE_D)
+MOC_INLINE_VALFN(moc_sc, signed char, MOC_TYPE_SC)
+MOC_INLINE_VALFN(moc_uc, unsigned char, MOC_TYPE_UC)
+MOC_INLINE_VALFN(moc_us, unsigned short, MOC_TYPE_US)
+MOC_INLINE_VALFN(moc_ui, unsigned int, MOC_TYPE_UI)
+MOC_INLINE_VALFN(moc_ul, unsigned long, MOC_TYPE_UL)
+MOC_INLINE_VALFN(moc_fn, moc_fnptr, MOC_TYPE_FN)
+
+MOC_INLINE_VALFN(moc_p, void *, MOC_TYPE_P)
+MOC_INLINE_VALFN(moc_p_c, char *, MOC_TYPE_P_C)
+MOC_INLINE_VALFN(moc_p_s, short *, MOC_TYPE_P_S)
+MOC_INLINE_VALFN(moc_p_i, int *, MOC_TYPE_P_I)
+MOC_INLINE_VALFN(moc_p_l, long *, MOC_TYPE_P_L)
+MOC_INLINE_VALFN(moc_p_f, float *, MOC_TYPE_P_F)
+MOC_INLINE_VALFN(moc_p_d, double *, MOC_TYPE_P_D)
+MOC_INLINE_VALFN(moc_p_sc, signed char *, MOC_TYPE_P_SC)
+MOC_INLINE_VALFN(moc_p_uc, unsigned char *, MOC_TYPE_P_UC)
+MOC_INLINE_VALFN(moc_p_us, unsigned short *, MOC_TYPE_P_US)
+MOC_INLINE_VALFN(moc_p_ui, unsigned int *, MOC_TYPE_P_UI)
+MOC_INLINE_VALFN(moc_p_ul, unsigned long *, MOC_TYPE_P_UL)
+MOC_INLINE_VALFN(moc_p_fn, moc_fnptr *, MOC_TYPE_P_FN)
+
+MOC_INLINE_VALFN(moc_cp, const void *, MOC_TYPE_CP)
+MOC_INLINE_VALFN(moc_cp_c, const char *, MOC_TYPE_CP_C)
+MOC_INLINE_VALFN(moc_cp_s, const short *, MOC_TYPE_CP_S)
+MOC_INLINE_VALFN(moc_cp_i, const int *, MOC_TYPE_CP_I)
+MOC_INLINE_VALFN(moc_cp_l, const long *, MOC_TYPE_CP_L)
+MOC_INLINE_VALFN(moc_cp_f, const float *, MOC_TYPE_CP_F)
+MOC_INLINE_VALFN(moc_cp_d, const double *, MOC_TYPE_CP_D)
+MOC_INLINE_VALFN(moc_cp_sc, const signed char *, MOC_TYPE_CP_SC)
+MOC_INLINE_VALFN(moc_cp_uc, const unsigned char *, MOC_TYPE_CP_UC)
+MOC_INLINE_VALFN(moc_cp_us, const unsigned short *, MOC_TYPE_CP_US)
+MOC_INLINE_VALFN(moc_cp_ui, const unsigned int *, MOC_TYPE_CP_UI)
+MOC_INLINE_VALFN(moc_cp_ul, const unsigned long *, MOC_TYPE_CP_UL)
+MOC_INLINE_VALFN(moc_cp_fn, const moc_fnptr *, MOC_TYPE_CP_FN)
+
+MOC_INLINE_GETFN(moc_get_c, char)
+MOC_INLINE_GETFN(moc_get_s, short)
+MOC_INLINE_GETFN(moc_get_i, int)
+MOC_INLINE_GETFN(moc_get_l, long)
+MOC_INLINE_GETFN(moc_get_f, float)
+MOC_INLINE_GETFN(moc_get_d, double)
+MOC_INLINE_GETFN(moc_get_sc, signed char)
+MOC_INLINE_GETFN(moc_get_uc, unsigned char)
+MOC_INLINE_GETFN(moc_get_us, unsigned short)
+MOC_INLINE_GETFN(moc_get_ui, unsigned int)
+MOC_INLINE_GETFN(moc_get_ul, unsigned long)
+MOC_INLINE_GETFN(moc_get_fn, moc_fnptr)
+
+MOC_INLINE_GETFN(moc_get_p, void *)
+MOC_INLINE_GETFN(moc_get_p_c, char *)
+MOC_INLINE_GETFN(moc_get_p_s, short *)
+MOC_INLINE_GETFN(moc_get_p_i, int *)
+MOC_INLINE_GETFN(moc_get_p_l, long *)
+MOC_INLINE_GETFN(moc_get_p_f, float *)
+MOC_INLINE_GETFN(moc_get_p_d, double *)
+MOC_INLINE_GETFN(moc_get_p_sc, signed char *)
+MOC_INLINE_GETFN(moc_get_p_uc, unsigned char *)
+MOC_INLINE_GETFN(moc_get_p_us, unsigned short *)
+MOC_INLINE_GETFN(moc_get_p_ui, unsigned int *)
+MOC_INLINE_GETFN(moc_get_p_ul, unsigned long *)
+MOC_INLINE_GETFN(moc_get_p_fn, moc_fnptr *)
+
+MOC_INLINE_GETFN(moc_get_cp, const void *)
+MOC_INLINE_GETFN(moc_get_cp_c, const char *)
+MOC_INLINE_GETFN(moc_get_cp_s, const short *)
+MOC_INLINE_GETFN(moc_get_cp_i, const int *)
+MOC_INLINE_GETFN(moc_get_cp_l, const long *)
+MOC_INLINE_GETFN(moc_get_cp_f, const float *)
+MOC_INLINE_GETFN(moc_get_cp_d, const double *)
+MOC_INLINE_GETFN(moc_get_cp_sc, const signed char *)
+MOC_INLINE_GETFN(moc_get_cp_uc, const unsigned char *)
+MOC_INLINE_GETFN(moc_get_cp_us, const unsigned short *)
+MOC_INLINE_GETFN(moc_get_cp_ui, const unsigned int *)
+MOC_INLINE_GETFN(moc_get_cp_ul, const unsigned long *)
+MOC_INLINE_GETFN(moc_get_cp_fn, const moc_fnptr *)
+
+#else /* MOC_INLINE_FN */
+
 /* The type functions are used for providing the type of the return value
  * of the mock because it checks that the type of the value is equal: */
 
@@ -227,11 +455,202 @@ const unsigned int   *moc_get_cp_ui(struct moc_value value);
 const unsigned long  *moc_get_cp_ul(struct moc_value value);
 const moc_fnptr *moc_get_cp_fn(struct moc_value value);
 
+#endif /* MOC_INLINE_FN */
+
 /**
  * Returns the type of the given Mocito value.
  */
 moc_type moc_get_type(struct moc_value value);
 
+/**
+ * Returns the type of the struct values, which are checked by their
+ * size and their tag when they are extracted.
+ */
+moc_type moc_type_st(void);
+
+/**
+ * Converts a struct passed by value to a Mocito value that refers to
+ * its bytes without copying them, with its size and a tag chosen by the
+ * user for distinguishing the structs of equal size. The values given
+ * to the matchers and the responders are copied when adding a mapping,
+ * so they can refer to local variables. The struct values are compared
+ * by their bytes like with memcmp, so their padding must be cleared,
+ * unless their tag has a user type with a comparison function.
+ */
+struct moc_value moc_st(const void *data, unsigned int size,
+		unsigned short tag);
+
+#define MOC_ST(obj, tag) moc_st(&(obj), sizeof(obj), (tag))
+
+/**
+ * Copies the bytes of the struct value to the given struct, returning
+ * moc_false without copying them if the value is not a struct, or if it
+ * has another size or tag, which is reported as an error naming the
+ * user type of the given tag.
+ */
+moc_bool moc_get_st(struct moc_value value, void *dest, unsigned int size,
+		unsigned short tag);
+
+#define MOC_GET_ST(value, obj, tag) \
+	moc_get_st((value), &(obj), sizeof(obj), (tag))
+
+/**
+ * Type of the functions comparing two values of a user type, returning
+ * an integer less than, equal to or greater than 0 like memcmp.
+ */
+typedef int (*moc_cmpfn_t)(const void *data1, const void *data2);
+
+/**
+ * Type of the functions returning the hash of a value of a user type,
+ * that must be equal for the values that are equal when compared.
+ */
+typedef unsigned long (*moc_hashfn_t)(const void *data);
+
+/**
+ * Type defined by the user for the struct values of its tag, whose
+ * comparison and hash functions replace the ones of their bytes in the
+ * matchers like moc_eq or moc_lt, and in the fingerprint of mappings.
+ * Its name is the one of the expected struct in the errors of moc_get_st.
+ */
+struct moc_usertype {
+	unsigned short tag;
+	const char *name;
+	unsigned int size;
+	moc_cmpfn_t cmp;
+	moc_hashfn_t hash;
+};
+
+#define MOC_USERTYPE(tag, ctype, cmp, hash) \
+	{ (tag), #ctype, sizeof(ctype), (cmp), (hash) }
+
+/**
+ * Sets the table of user types, that is not copied and is unset by
+ * moc_init. Their values are created with MOC_ST and their tags.
+ */
+void moc_set_usertypes(const struct moc_usertype *types,
+		unsigned int ntypes);
+
+#if defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L
+
+/**
+ * Converts a value of a basic type to a Mocito value, choosing the
+ * function for its type at compile time (C11). The pointers to other
+ * types are converted with moc_p.
+ */
+#define MOC_V(x) _Generic((x), \
+	char: moc_c, \
+	short: moc_s, \
+	int: moc_i, \
+	long: moc_l, \
+	float: moc_f, \
+	double: moc_d, \
+	signed char: moc_sc, \
+	unsigned char: moc_uc, \
+	unsigned short: moc_us, \
+	unsigned int: moc_ui, \
+	unsigned long: moc_ul, \
+	moc_fnptr: moc_fn, \
+	void *: moc_p, \
+	char *: moc_p_c, \
+	short *: moc_p_s, \
+	int *: moc_p_i, \
+	long *: moc_p_l, \
+	float *: moc_p_f, \
+	double *: moc_p_d, \
+	signed char *: moc_p_sc, \
+	unsigned char *: moc_p_uc, \
+	unsigned short *: moc_p_us, \
+	unsigned int *: moc_p_ui, \
+	unsigned long *: moc_p_ul, \
+	moc_fnptr *: moc_p_fn, \
+	const void *: moc_cp, \
+	const char *: moc_cp_c, \
+	const short *: moc_cp_s, \
+	const int *: moc_cp_i, \
+	const long *: moc_cp_l, \
+	const float *: moc_cp_f, \
+	const double *: moc_cp_d, \
+	const signed char *: moc_cp_sc, \
+	const unsigned char *: moc_cp_uc, \
+	const unsigned short *: moc_cp_us, \
+	const unsigned int *: moc_cp_ui, \
+	const unsigned long *: moc_cp_ul, \
+	const moc_fnptr *: moc_cp_fn, \
+	default: moc_p)(x)
+
+/**
+ * Returns the constant of the type of a value of a basic type (C11).
+ */
+#define MOC_TYPEOF(x) _Generic((x), \
+	char: MOC_TYPE_C, \
+	short: MOC_TYPE_S, \
+	int: MOC_TYPE_I, \
+	long: MOC_TYPE_L, \
+	float: MOC_TYPE_F, \
+	double: MOC_TYPE_D, \
+	signed char: MOC_TYPE_SC, \
+	unsigned char: MOC_TYPE_UC, \
+	unsigned short: MOC_TYPE_US, \
+	unsigned int: MOC_TYPE_UI, \
+	unsigned long: MOC_TYPE_UL, \
+	moc_fnptr: MOC_TYPE_FN, \
+	void *: MOC_TYPE_P, \
+	char *: MOC_TYPE_P_C, \
+	short *: MOC_TYPE_P_S, \
+	int *: MOC_TYPE_P_I, \
+	long *: MOC_TYPE_P_L, \
+	float *: MOC_TYPE_P_F, \
+	double *: MOC_TYPE_P_D, \
+	signed char *: MOC_TYPE_P_SC, \
+	unsigned char *: MOC_TYPE_P_UC, \
+	unsigned short *: MOC_TYPE_P_US, \
+	unsigned int *: MOC_TYPE_P_UI, \
+	unsigned long *: MOC_TYPE_P_UL, \
+	moc_fnptr *: MOC_TYPE_P_FN, \
+	const void *: MOC_TYPE_CP, \
+	const char *: MOC_TYPE_CP_C, \
+	const short *: MOC_TYPE_CP_S, \
+	const int *: MOC_TYPE_CP_I, \
+	const long *: MOC_TYPE_CP_L, \
+	const float *: MOC_TYPE_CP_F, \
+	const double *: MOC_TYPE_CP_D, \
+	const signed char *: MOC_TYPE_CP_SC, \
+	const unsigned char *: MOC_TYPE_CP_UC, \
+	const unsigned short *: MOC_TYPE_CP_US, \
+	const unsigned int *: MOC_TYPE_CP_UI, \
+	const unsigned long *: MOC_TYPE_CP_UL, \
+	const moc_fnptr *: MOC_TYPE_CP_FN, \
+	default: MOC_TYPE_P)
+
+/**
+ * Calls moc_act with the name of the function, the constant of the type
+ * returned and up to 7 parameters converted with MOC_V (C11), like in
+ * moc_get_i(MOC_ACT(myfn, MOC_TYPE_I, a, b)).
+ */
+#define MOC_ACT(...) MOC_ACT_N(MOC_NARGS(__VA_ARGS__), __VA_ARGS__)
+#define MOC_NARGS(...) MOC_NARGS_(__VA_ARGS__, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0)
+#define MOC_NARGS_(a1, a2, a3, a4, a5, a6, a7, a8, a9, n, ...) n
+#define MOC_ACT_N(n, ...) MOC_ACT_N_(n, __VA_ARGS__)
+#define MOC_ACT_N_(n, ...) MOC_ACT_##n(__VA_ARGS__)
+#define MOC_ACT_2(fn, ret) moc_act(#fn, ret, moc_values_0())
+#define MOC_ACT_3(fn, ret, a) moc_act(#fn, ret, moc_values_1(MOC_V(a)))
+#define MOC_ACT_4(fn, ret, a, b) moc_act(#fn, ret, \
+	moc_values_2(MOC_V(a), MOC_V(b)))
+#define MOC_ACT_5(fn, ret, a, b, c) moc_act(#fn, ret, \
+	moc_values_3(MOC_V(a), MOC_V(b), MOC_V(c)))
+#define MOC_ACT_6(fn, ret, a, b, c, d) moc_act(#fn, ret, \
+	moc_values_4(MOC_V(a), MOC_V(b), MOC_V(c), MOC_V(d)))
+#define MOC_ACT_7(fn, ret, a, b, c, d, e) moc_act(#fn, ret, \
+	moc_values_5(MOC_V(a), MOC_V(b), MOC_V(c), MOC_V(d), MOC_V(e)))
+#define MOC_ACT_8(fn, ret, a, b, c, d, e, f) moc_act(#fn, ret, \
+	moc_values_6(MOC_V(a), MOC_V(b), MOC_V(c), MOC_V(d), MOC_V(e), \
+		MOC_V(f)))
+#define MOC_ACT_9(fn, ret, a, b, c, d, e, f, g) moc_act(#fn, ret, \
+	moc_values_7(MOC_V(a), MOC_V(b), MOC_V(c), MOC_V(d), MOC_V(e), \
+		MOC_V(f), MOC_V(g)))
+
+#endif /* C11 */
+
 /**
  * Call-related data to be used optionally by matchers or responders.
  */
@@ -435,6 +854,91 @@ struct moc_responder moc_rparam_nochk(int nparam,
 struct moc_responder moc_rcall(moc_rspfn_call_t rspfn,
 		struct moc_value val);
 
+/**
+ * Type of the functions returning the current time in any unit.
+ */
+typedef unsigned long (*moc_clockfn_t)(void);
+
+/**
+ * Sets the function used by the spies for measuring the time of the
+ * calls, that must be set again after calling to moc_init.
+ */
+void moc_set_clock(moc_clockfn_t clockfn);
+
+#define MOC_SPYMAXPARAMS 7
+
+/**
+ * Recorder of the calls of the spies in a trace stored in the given
+ * buffer, counting the calls not recorded because the buffer was full
+ * or because they have struct parameters or results.
+ */
+struct moc_recorder {
+	char *buf;
+	unsigned long size;
+	unsigned long len;
+	unsigned long nlost;
+};
+
+/**
+ * Spy that forwards the calls of a mock to its real function, which
+ * receives the parameters of the call and returns its result as value,
+ * recording the last call and the time spent by the real function and
+ * the time spent by Mocito in the calls (from the beginning of moc_act,
+ * or of moc_has_mappings before it), if a clock is set. Only the first
+ * MOC_SPYMAXPARAMS parameters are stored, and nparams counts them.
+ */
+struct moc_spy {
+	moc_rspfn_call_t realfn;
+	unsigned long ncalls;
+	unsigned char nparams;
+	struct moc_value params[MOC_SPYMAXPARAMS];
+	struct moc_value result;
+	unsigned long realtime;
+	unsigned long moctime;
+	struct moc_recorder *rec;
+	unsigned char outparam;
+	unsigned char lenparam;
+};
+
+/**
+ * Initializes the spy with the function that forwards to the real one.
+ */
+void moc_init_spy(struct moc_spy *spy, moc_rspfn_call_t realfn);
+
+/**
+ * Returns a responder that calls to the real function of the spy.
+ */
+struct moc_responder moc_spy(struct moc_spy *spy);
+
+/**
+ * Initializes the recorder for writing a trace in the given buffer.
+ */
+void moc_init_recorder(struct moc_recorder *rec, char *buf,
+		unsigned long size);
+
+/**
+ * Makes the spy record its calls with the recorder, including the data
+ * written by the real function in the pointer parameter outparam (if
+ * not 0) with the size in bytes given by the parameter lenparam or by
+ * the returned value when lenparam is 0. The const char * parameters
+ * are recorded as strings and the other pointers are not recorded.
+ */
+void moc_spy_record(struct moc_spy *spy, struct moc_recorder *rec,
+		int outparam, int lenparam);
+
+/**
+ * Adds the mappings for replaying the calls of the trace, which is not
+ * copied and must not be modified while it is used. The calls with
+ * equal parameters are replayed with their responses in order, and the
+ * recorded data is copied to their out parameters. Returns the number
+ * of calls added, stopping at the first invalid one or at the first
+ * error adding its mapping. The values are recorded in the byte order
+ * of the host and the pointers returned are replayed with the recorded
+ * addresses, so the traces with pointer results can only be replayed
+ * by the process that recorded them.
+ */
+unsigned long moc_replay(const char *trace, unsigned long len);
+
 /** Structure for grouping a list of ordinary matchers. */
 struct moc_matchers_grp {
 	struct moc_matcher *elems;
@@ -594,4 +1098,556 @@ void moc_given_extra(const char *funcname, struct moc_matchers_grp mgrp,
 struct moc_value moc_act(const char *funcname, moc_type rettype,
 		struct moc_values_grp pgrp);
 
+/**
+ * Maximum number of parameters of the functions mocked with moc_act_v
+ * and moc_given_v, which receive arrays of any size owned by the caller
+ * instead of the groups limited to 7 elements.
+ */
+#define MOC_MAXPARAMS 126
+
+/**
+ * Equivalent to moc_given but receiving arrays of matchers, one for each
+ * function parameter, and of responders. The arrays are copied, so they
+ * can be local variables of the caller.
+ */
+void moc_given_v(const char *funcname, unsigned char nmatchers,
+		struct moc_matcher *matchers, unsigned char nresponders,
+		struct moc_responder *responders);
+
+/**
+ * Equivalent to moc_act but receiving an array of parameters owned by
+ * the caller, which are used without copying them, for functions with
+ * any number of parameters up to MOC_MAXPARAMS.
+ */
+struct moc_value moc_act_v(const char *funcname, moc_type rettype,
+		unsigned char nparams, struct moc_value *params);
+
+/**
+ * Equivalent to moc_act_v for the variadic functions, receiving their
+ * fixed parameters in an array owned by the caller, and the types of
+ * the variable arguments that are read from the va_list, like the ones
+ * of ioctl, which depend on the fixed parameters.
+ */
+struct moc_value moc_act_va(const char *funcname, moc_type rettype,
+		unsigned char nfixed, const struct moc_value *fixed,
+		unsigned char nvar, const moc_type *vartypes, va_list ap);
+
+/**
+ * Equivalent to moc_act_va for the functions with a printf format after
+ * the fixed parameters, that defines the types of the variable arguments.
+ * The parameters of the call are the fixed ones, the format and the
+ * arguments. Each format is parsed only once while it is in a cache
+ * searched by its pointer, so the formats must not be modified.
+ */
+struct moc_value moc_act_fmt(const char *funcname, moc_type rettype,
+		unsigned char nfixed, const struct moc_value *fixed,
+		const char *format, va_list ap);
+
+/**
+ * Declares the signature of a mocked function, with the type of its
+ * return value and the types of its parameters in an array that must
+ * be kept until the next moc_init. Its mappings are then checked when
+ * they are added, reporting the errors of types in moc_given instead of
+ * in the calls, which only compare their types with the signature.
+ * Returns false if the signature or the existing mappings are invalid.
+ */
+moc_bool moc_declare(const char *funcname, moc_type rettype,
+		unsigned char nparams, const moc_type *paramtypes);
+
+/**
+ * Sets if the calls to the declared functions are trusted, skipping all
+ * the checks of their types, including the type of the returned value,
+ * as their mappings were checked with the signature when they were
+ * added. Used for mocks called in loops by benchmarks, where those
+ * checks take most of the time. It is unset by moc_init.
+ */
+void moc_set_trusted(moc_bool trusted);
+
+/**
+ * Handle of a mocked function that remembers where the function was
+ * found in its first call after moc_init, so the next calls do not
+ * need to search it by name. Declare it static inside the mock using
+ * MOC_HANDLE(fn) as initializer, and pass it to moc_act_h.
+ */
+struct moc_handle {
+	const char *funcname;
+	unsigned long epoch;
+	unsigned int pos;
+	unsigned int found;
+	unsigned long tblstamp; /* table searched by moc_has_mappings */
+	unsigned int tblfound; /* nparams * 2 + 1 if found in the table */
+};
+
+#define MOC_HANDLE(fn) { #fn, 0, 0, 0, 0, 0 }
+
+/**
+ * Equivalent to moc_act but receiving the handle of the function.
+ */
+struct moc_value moc_act_h(struct moc_handle *handle, moc_type rettype,
+		struct moc_values_grp pgrp);
+
+/**
+ * Equivalent to ncalls calls to moc_act_h, with the parameters of each
+ * call following those of the previous call in the params array, and
+ * storing the returned values in the results array. The function is
+ * searched and the commands are polled only once for all the calls.
+ */
+void moc_act_batch(struct moc_handle *handle, moc_type rettype,
+		unsigned long ncalls, unsigned char nparams,
+		struct moc_value *params, struct moc_value *results);
+
+/**
+ * Adds a mapping like moc_given but only for the calls to the function
+ * made with moc_act_self for the given instance, like the functions of
+ * an interface implemented by a struct of function pointers.
+ */
+void moc_given_self(const void *self, const char *funcname,
+		struct moc_matchers_grp mgrp, struct moc_responders_grp rgrp);
+
+/**
+ * Equivalent to moc_act_h for a function of the given instance, using
+ * the mappings added for it with moc_given_self, which are found in a
+ * cache of the instances, or else the mappings added with moc_given.
+ * The mocks of the interfaces are generated by mocgen -v.
+ */
+struct moc_value moc_act_self(struct moc_handle *handle, const void *self,
+		moc_type rettype, struct moc_values_grp pgrp);
+
+/**
+ * Returns if the function of the handle with the given number of
+ * parameters has mappings, without searching again the functions
+ * already searched. Used by the linker wrappers for calling to the
+ * real function when the function is not mocked. The mappings added
+ * with moc_given_self for an instance are not counted.
+ */
+moc_bool moc_has_mappings(struct moc_handle *handle, unsigned char nparams);
+
+/**
+ * Compiles the matchers of the mappings of the given mocked function,
+ * validating them once, so the calls to the function will compare the
+ * parameters with the values of the predefined matchers directly.
+ *
+ * Intended for functions with many mappings that are stable, because
+ * adding a new mapping to the function returns it to the normal path.
+ * The results of the calls are equal to those of the normal path.
+ */
+void moc_compile(const char *funcname);
+
+/**
+ * Maximum number of parameters of a function in a static table row.
+ */
+#define MOC_TBLMAXPARAMS 7
+
+/**
+ * Cell of a static table row describing, using only constant data,
+ * the matcher of a parameter or the value returned by the function.
+ * The type is coded as the standard type * 4 + the pointer type.
+ */
+struct moc_tblcell {
+	moc_type type;
+	unsigned char kind;
+	long ival;
+	double dval;
+	const void *pval;
+};
+
+/**
+ * Row of a static table that maps the matchers of the parameters
+ * of a function to the value that must be returned when all match.
+ */
+struct moc_tblrow {
+	const char *funcname;
+	unsigned char nparams;
+	struct moc_tblcell ret;
+	struct moc_tblcell params[MOC_TBLMAXPARAMS];
+};
+
+#define MOC_TBLCELL(type, kind, ival, dval, pval) \
+	{ (type), (kind), (ival), (dval), (pval) }
+
+/* Kinds of cells: */
+#define MOC_TBLKIND_ANY 1
+#define MOC_TBLKIND_EQ  2
+#define MOC_TBLKIND_STR 3
+#define MOC_TBLKIND_RET 4
+
+/* Cells for matching parameters: */
+
+#define MOC_TANY MOC_TBLCELL(0, MOC_TBLKIND_ANY, 0L, 0.0, 0)
+#define MOC_TEQ_C(v)  MOC_TBLCELL(4, MOC_TBLKIND_EQ, (long) (v), 0.0, 0)
+#define MOC_TEQ_S(v)  MOC_TBLCELL(8, MOC_TBLKIND_EQ, (long) (v), 0.0, 0)
+#define MOC_TEQ_I(v)  MOC_TBLCELL(12, MOC_TBLKIND_EQ, (long) (v), 0.0, 0)
+#define MOC_TEQ_L(v)  MOC_TBLCELL(16, MOC_TBLKIND_EQ, (long) (v), 0.0, 0)
+#define MOC_TEQ_F(v)  MOC_TBLCELL(20, MOC_TBLKIND_EQ, 0L, (double) (v), 0)
+#define MOC_TEQ_D(v)  MOC_TBLCELL(24, MOC_TBLKIND_EQ, 0L, (double) (v), 0)
+#define MOC_TEQ_SC(v) MOC_TBLCELL(28, MOC_TBLKIND_EQ, (long) (v), 0.0, 0)
+#define MOC_TEQ_UC(v) MOC_TBLCELL(32, MOC_TBLKIND_EQ, (long) (v), 0.0, 0)
+#define MOC_TEQ_US(v) MOC_TBLCELL(36, MOC_TBLKIND_EQ, (long) (v), 0.0, 0)
+#define MOC_TEQ_UI(v) MOC_TBLCELL(40, MOC_TBLKIND_EQ, (long) (v), 0.0, 0)
+#define MOC_TEQ_UL(v) MOC_TBLCELL(44, MOC_TBLKIND_EQ, (long) (v), 0.0, 0)
+#define MOC_TEQ_P(v)  MOC_TBLCELL(1, MOC_TBLKIND_EQ, 0L, 0.0, (v))
+#define MOC_TEQ_CP(v) MOC_TBLCELL(2, MOC_TBLKIND_EQ, 0L, 0.0, (v))
+#define MOC_TEQ_CSTR(v) MOC_TBLCELL(6, MOC_TBLKIND_STR, 0L, 0.0, (v))
+
+/* Cells for returning values: */
+
+#define MOC_TRET_VOID  MOC_TBLCELL(0, MOC_TBLKIND_RET, 0L, 0.0, 0)
+#define MOC_TRET_C(v)  MOC_TBLCELL(4, MOC_TBLKIND_RET, (long) (v), 0.0, 0)
+#define MOC_TRET_S(v)  MOC_TBLCELL(8, MOC_TBLKIND_RET, (long) (v), 0.0, 0)
+#define MOC_TRET_I(v)  MOC_TBLCELL(12, MOC_TBLKIND_RET, (long) (v), 0.0, 0)
+#define MOC_TRET_L(v)  MOC_TBLCELL(16, MOC_TBLKIND_RET, (long) (v), 0.0, 0)
+#define MOC_TRET_F(v)  MOC_TBLCELL(20, MOC_TBLKIND_RET, 0L, (double) (v), 0)
+#define MOC_TRET_D(v)  MOC_TBLCELL(24, MOC_TBLKIND_RET, 0L, (double) (v), 0)
+#define MOC_TRET_SC(v) MOC_TBLCELL(28, MOC_TBLKIND_RET, (long) (v), 0.0, 0)
+#define MOC_TRET_UC(v) MOC_TBLCELL(32, MOC_TBLKIND_RET, (long) (v), 0.0, 0)
+#define MOC_TRET_US(v) MOC_TBLCELL(36, MOC_TBLKIND_RET, (long) (v), 0.0, 0)
+#define MOC_TRET_UI(v) MOC_TBLCELL(40, MOC_TBLKIND_RET, (long) (v), 0.0, 0)
+#define MOC_TRET_UL(v) MOC_TBLCELL(44, MOC_TBLKIND_RET, (long) (v), 0.0, 0)
+#define MOC_TRET_P(v)  MOC_TBLCELL(1, MOC_TBLKIND_RET, 0L, 0.0, (v))
+#define MOC_TRET_CP(v) MOC_TBLCELL(2, MOC_TBLKIND_RET, 0L, 0.0, (v))
+#define MOC_TRET_CP_C(v) MOC_TBLCELL(6, MOC_TBLKIND_RET, 0L, 0.0, (v))
+
+/* Rows of a table, receiving the function, the returned cell and
+ * one cell for each parameter: */
+
+#define MOC_TROW_0(fn, ret) { MOC_FN(fn), 0, ret, { MOC_TANY } }
+#define MOC_TROW_1(fn, ret, c1) { MOC_FN(fn), 1, ret, { c1 } }
+#define MOC_TROW_2(fn, ret, c1, c2) { MOC_FN(fn), 2, ret, { c1, c2 } }
+#define MOC_TROW_3(fn, ret, c1, c2, c3) \
+	{ MOC_FN(fn), 3, ret, { c1, c2, c3 } }
+#define MOC_TROW_4(fn, ret, c1, c2, c3, c4) \
+	{ MOC_FN(fn), 4, ret, { c1, c2, c3, c4 } }
+#define MOC_TROW_5(fn, ret, c1, c2, c3, c4, c5) \
+	{ MOC_FN(fn), 5, ret, { c1, c2, c3, c4, c5 } }
+#define MOC_TROW_6(fn, ret, c1, c2, c3, c4, c5, c6) \
+	{ MOC_FN(fn), 6, ret, { c1, c2, c3, c4, c5, c6 } }
+#define MOC_TROW_7(fn, ret, c1, c2, c3, c4, c5, c6, c7) \
+	{ MOC_FN(fn), 7, ret, { c1, c2, c3, c4, c5, c6, c7 } }
+
+/**
+ * Defines a table of mappings as initialized read-only data, so it
+ * costs nothing to build at run time, for example:
+ * MOC_STATIC_GIVEN_TABLE(fixture) = {
+ *     MOC_TROW_1(myfn, MOC_TRET_I(-1), MOC_TEQ_I(0)),
+ *     MOC_TROW_1(myfn, MOC_TRET_I(1), MOC_TANY)
+ * };
+ */
+#define MOC_STATIC_GIVEN_TABLE(name) \
+	static const struct moc_tblrow name[]
+
+/**
+ * Links the given table of mappings to the current configuration,
+ * without copying it, replacing any previously attached table.
+ *
+ * The rows of the table are checked in order only when no mapping
+ * added with moc_given() matches a call, so they work as defaults.
+ * Handles remember which functions the table mocks until it is attached
+ * again, so the table must be attached again after changing its rows.
+ */
+void moc_attach_table(const struct moc_tblrow *rows, unsigned int nrows);
+
+/**
+ * Maximum number of states of a state machine, numbered from 0.
+ */
+#define MOC_FSMSTATES 32
+
+/**
+ * Transition of a state machine: in the given state, a call to the
+ * function whose first parameter matches the cell (MOC_TANY or a
+ * MOC_TEQ_ cell) returns the value of the MOC_TRET_ cell and moves the
+ * machine to the next state.
+ */
+struct moc_transition {
+	int state;
+	const char *funcname;
+	struct moc_tblcell param;
+	struct moc_tblcell ret;
+	int next;
+};
+
+#define MOC_TRANSITION(state, fn, param, ret, next) \
+	{ (state), MOC_FN(fn), param, ret, (next) }
+
+/**
+ * State machine with its current state and the position of the first
+ * transition of each state, for finding the transitions of the current
+ * state without checking the others.
+ */
+struct moc_fsm {
+	const struct moc_transition *transitions;
+	unsigned int first[MOC_FSMSTATES + 1];
+	int state;
+};
+
+/**
+ * Initializes the state machine with a table of transitions sorted by
+ * their states, that is not copied, and the initial state. Returns
+ * moc_false after reporting an error if the table is invalid.
+ */
+moc_bool moc_init_fsm(struct moc_fsm *fsm,
+		const struct moc_transition *transitions,
+		unsigned int ntransitions, int state);
+
+/**
+ * Returns the current state of the state machine.
+ */
+int moc_fsm_state(const struct moc_fsm *fsm);
+
+/**
+ * Returns a responder that executes the transition of the state machine
+ * matching the call in the current state, returning its value, and
+ * reports an error if no transition matches. It can be used in the
+ * mappings of all the functions of a protocol.
+ */
+struct moc_responder moc_transit(struct moc_fsm *fsm);
+
+struct moc_regfile;
+struct moc_register;
+
+/**
+ * Type of the functions called when a register is read, before getting
+ * its value, or after it is written, receiving the value written.
+ */
+typedef void (*moc_regfn_t)(struct moc_regfile *file,
+		struct moc_register *reg, unsigned long value);
+
+/**
+ * Register of a device with its address, its current value, the masks
+ * of the bits cleared when it is read and of the bits cleared writing 1,
+ * the optional functions called on its accesses and their counters.
+ */
+struct moc_register {
+	unsigned long addr;
+	unsigned long value;
+	unsigned long rclear;
+	unsigned long w1clear;
+	moc_regfn_t onread;
+	moc_regfn_t onwrite;
+	unsigned long nreads;
+	unsigned long nwrites;
+};
+
+#define MOC_REGISTER(addr, value, rclear, w1clear) \
+	{ (addr), (value), (rclear), (w1clear), 0, 0, 0, 0 }
+#define MOC_REGISTER_HOOKS(addr, value, rclear, w1clear, onread, onwrite) \
+	{ (addr), (value), (rclear), (w1clear), (onread), (onwrite), 0, 0 }
+
+/**
+ * Register file of a device, with the type of the values of its read
+ * accessor, and the distance between its registers when it is regular.
+ */
+struct moc_regfile {
+	struct moc_register *regs;
+	unsigned int nregs;
+	moc_type type;
+	unsigned long stride;
+};
+
+/**
+ * Initializes the register file with an array of registers sorted by
+ * their addresses, that is not copied, and the integer type returned by
+ * the read accessor. The registers at regular distances are found by
+ * their index, and the others with a binary search.
+ */
+moc_bool moc_init_regfile(struct moc_regfile *file,
+		struct moc_register *regs, unsigned int nregs,
+		moc_type type);
+
+/**
+ * Returns the register of the address, or a null pointer if not found.
+ */
+struct moc_register *moc_find_register(struct moc_regfile *file,
+		unsigned long addr);
+
+/**
+ * Returns a responder for the read accessor of the register file, that
+ * receives the address as its first parameter and returns the value of
+ * the register, clearing after it the bits in its rclear mask.
+ */
+struct moc_responder moc_read_register(struct moc_regfile *file);
+
+/**
+ * Returns a responder for the write accessor of the register file, that
+ * receives the address and the value, clearing the bits written with 1
+ * in its w1clear mask and setting the other bits to the value.
+ */
+struct moc_responder moc_write_register(struct moc_regfile *file);
+
+/**
+ * Writes in the given buffer the C source code of a dispatch function
+ * for each mocked function of the current configuration whose mappings
+ * only use predefined matchers and responders returning values, named
+ * moc_aot_ followed by the name of the function, ending with a '\0'.
+ * Returns the length of the whole code, that has not been completely
+ * written when it is not less than the given size of the buffer.
+ *
+ * The generated functions keep the configuration that was generated
+ * and call to moc_act() for reporting errors or calls that don't match.
+ * Their sequences of responders restart after each moc_init.
+ */
+unsigned long moc_gen_aot(char *buf, unsigned long size);
+
+/**
+ * Returns the number of calls to moc_init, used by the generated code
+ * for resetting its state when the mappings are added again.
+ */
+unsigned long moc_epoch(void);
+
+/**
+ * Declares the dispatch function generated for the given function.
+ */
+#define MOC_AOT_DECL(fn) struct moc_value moc_aot_##fn(moc_type rettype, \
+		struct moc_values_grp pgrp)
+
+/**
+ * Calls to moc_act() for the given function, or to its generated
+ * dispatch function when compiling with MOC_AOT defined.
+ */
+#ifdef MOC_AOT
+#define MOC_ACT_AOT(fn, rettype, pgrp) moc_aot_##fn(rettype, pgrp)
+#else
+#define MOC_ACT_AOT(fn, rettype, pgrp) moc_act(MOC_FN(fn), rettype, pgrp)
+#endif
+
+/**
+ * Sets the memory used for storing the strings of the commands, that
+ * is emptied by moc_init and when the mappings are reset by commands.
+ */
+void moc_init_store(char *mem, unsigned long size);
+
+/**
+ * Scenario that can be selected by commands, named with the given name
+ * and configured by its setup function after removing the mappings.
+ */
+struct moc_scenario {
+	const char *name;
+	void (*setup)(void);
+};
+
+/**
+ * Sets the list of scenarios that can be selected with commands, that
+ * is not copied and is unset by moc_init.
+ */
+void moc_set_scenarios(const struct moc_scenario *scenarios,
+		unsigned int nscenarios);
+
+/**
+ * Executes the given configuration commands, separated by newlines or
+ * semicolons, and returns moc_false after reporting the first invalid
+ * command. The strings are copied to the memory of moc_init_store.
+ *
+ *   given FUNCTION MATCHER... [returns VALUE...]
+ *       Adds a mapping for the function, with a matcher per parameter,
+ *       returning the values in turn (or void). MATCHER is any, or VALUE
+ *       with an optional comparison operator: ==, !=, <, <=, > or >=.
+ *   reset
+ *       Removes all the mappings added by moc_given or by commands.
+ *   scenario NAME
+ *       Removes all the mappings and calls to the setup of the scenario.
+ *
+ * VALUE is a C literal: an integer with optional U/L suffixes, a real
+ * number with optional F suffix, a 'c' character or a "string" (with
+ * const char * type), with an optional cast like (short) or (unsigned
+ * char), typed as in C so that 'c' is an int. Text after # is ignored.
+ */
+moc_bool moc_command(const char *cmds);
+
+/**
+ * Returns the hash of the text of some commands, for naming the files
+ * where their compiled form is cached.
+ */
+unsigned long moc_command_hash(const char *cmds);
+
+/**
+ * Compiles the commands to the given buffer, using the memory of
+ * moc_init_store for the strings while parsing them, and returns the
+ * length of the compiled form or 0 if invalid or without enough space.
+ */
+unsigned long moc_compile_commands(const char *cmds, char *buf,
+		unsigned long size);
+
+/**
+ * Executes compiled commands without parsing them again, returning
+ * moc_false if their hash is not the given one (for recompiling them)
+ * or after reporting an error. The strings point to the compiled form,
+ * that must be kept until the next moc_init.
+ */
+moc_bool moc_load_commands(const char *bin, unsigned long len,
+		unsigned long hash);
+
+/**
+ * Type of the functions called at the beginning of each call to a mock.
+ */
+typedef void (*moc_pollfn_t)(void);
+
+/**
+ * Sets a function that will be called at the beginning of each call to
+ * a mock, for applying commands received from other threads between the
+ * calls. It is not called by the calls to mocks nested in the matchers
+ * or responders of another call. It is not unset by moc_init.
+ */
+void moc_set_pollfn(moc_pollfn_t pollfn);
+
+/**
+ * Returns a fingerprint of the calls to moc_given (or to the functions
+ * using it) made since moc_init, of their functions, matchers and
+ * responders, that changes if any of them changes. It is a 64-bit hash
+ * truncated to the size of unsigned long.
+ */
+unsigned long moc_fingerprint(void);
+
+/**
+ * If the current mappings were added by the last call to moc_reuse with
+ * the same setup function, runs it only for computing the fingerprint
+ * of its mappings and, if it is the one of the current mappings, keeps
+ * them with their responders in the initial order and returns moc_true.
+ * Otherwise removes all the mappings, runs the setup function for adding
+ * them and returns moc_false. The setup function runs twice only when
+ * its mappings change, and its other effects happen in both runs.
+ */
+moc_bool moc_reuse(void (*setup)(void));
+
+/**
+ * Region of the code under test, from the address of its start to the
+ * address after its end, identified by a number for the matchers.
+ */
+struct moc_region {
+	const void *start;
+	const void *end;
+	int id;
+};
+
+/**
+ * Sets the table of regions of the callers of the mocks, sorted by their
+ * start addresses (as listed by nm -n), that is not copied and is unset
+ * by moc_init.
+ */
+void moc_set_regions(const struct moc_region *regions,
+		unsigned int nregions);
+
+/**
+ * Address where the current function returns, for passing to
+ * moc_set_caller from a mock that is not inlined in its callers.
+ */
+#ifdef __GNUC__
+#define MOC_CALLER() __builtin_return_address(0)
+#else
+#define MOC_CALLER() ((void *) 0)
+#endif
+
+/**
+ * Searches the region of the given address of the caller of a mock, for
+ * the calls to moc_caller in the matchers of the next call to a mock,
+ * which forgets it. Mocks call it before moc_act as
+ * moc_set_caller(MOC_CALLER()), and moc_caller does not match the calls
+ * of the mocks that do not call it.
+ */
+void moc_set_caller(const void *addr);
+
+/**
+ * Returns an extra matcher that matches when the mock was called from
+ * the region with the given id, as found by the last moc_set_caller.
+ */
+struct moc_matcher moc_caller(int id);
+
 #endif /* MOCITO_H */
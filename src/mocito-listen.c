@@ -0,0 +1,192 @@
+/*
+   Mocito is a mocking library for writing unit tests of C code.
+   Copyright (C) 2025 Carlos Rica Espinosa <jasampler@gmail.com>
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software Foundation,
+   Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+*/
+
+/*
+ * Listener of a Unix socket receiving the commands of moc_command() for
+ * reconfiguring the mocks of a running process, for example with:
+ *
+ *   echo 'given read any any any returns -1L' | nc -U /tmp/mocito.sock
+ *
+ * Each line is a command that is answered with "ok" or "error: " and the
+ * message. The commands are applied by the thread calling the mocks,
+ * before its next call to them, so the mappings are never changed while
+ * a call is using them, and the answer waits until then.
+ *
+ * Unlike the rest of Mocito this file depends on a POSIX system with
+ * threads and must be built with the program:
+ *
+ *   cc -Iinclude program.c src/mocito.c src/mocito-listen.c -lpthread
+ */
+
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 200112L
+#endif
+
+#include "mocito.h"
+#include "mocito-listen.h"
+#include <pthread.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+/* Maximum length of a command line. */
+#define MOC_LISTEN_MAXLINE 1024
+
+static pthread_mutex_t moc_listen_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t moc_listen_done = PTHREAD_COND_INITIALIZER;
+static char moc_listen_line[MOC_LISTEN_MAXLINE];
+static int moc_listen_pending;
+static const char *moc_listen_error;
+
+/* Saves the message of the error instead of ending the program. */
+static void moc_listen_errfn(void) {
+	moc_listen_error = moc_errmsg();
+}
+
+/* Applies the pending command from the thread calling the mocks,
+ * without waiting for the listener when it has the lock. */
+static void moc_listen_poll(void) {
+	moc_errfn_t errfn;
+	if (pthread_mutex_trylock(&moc_listen_mutex) != 0) {
+		return;
+	}
+	if (! moc_listen_pending) {
+		pthread_mutex_unlock(&moc_listen_mutex);
+		return;
+	}
+	errfn = moc_get_errfn();
+	moc_set_errfn(moc_listen_errfn);
+	moc_listen_error = NULL;
+	if (! moc_command(moc_listen_line) && moc_listen_error == NULL) {
+		moc_listen_error = "invalid command";
+	}
+	moc_set_errfn(errfn);
+	moc_listen_pending = 0;
+	pthread_cond_signal(&moc_listen_done);
+	pthread_mutex_unlock(&moc_listen_mutex);
+}
+
+/* Writes all the bytes, returning -1 if the connection failed. */
+static int moc_listen_write(int fd, const char *buf, size_t len) {
+	ssize_t n;
+	while (len > 0) {
+		n = write(fd, buf, len);
+		if (n <= 0) {
+			return -1;
+		}
+		buf += n;
+		len -= (size_t) n;
+	}
+	return 0;
+}
+
+/* Writes the reply to a command, returning -1 if it cannot be written. */
+static int moc_listen_reply(int fd, const char *err) {
+	if (err == NULL) {
+		return moc_listen_write(fd, "ok\n", 3);
+	}
+	if (moc_listen_write(fd, "error: ", 7) != 0
+			|| moc_listen_write(fd, err, strlen(err)) != 0) {
+		return -1;
+	}
+	return moc_listen_write(fd, "\n", 1);
+}
+
+/* Passes the line to the thread calling the mocks and writes the reply,
+ * returning -1 if it cannot be written. */
+static int moc_listen_apply(int fd, const char *line) {
+	const char *err;
+	pthread_mutex_lock(&moc_listen_mutex);
+	strcpy(moc_listen_line, line);
+	moc_listen_pending = 1;
+	while (moc_listen_pending) {
+		pthread_cond_wait(&moc_listen_done, &moc_listen_mutex);
+	}
+	err = moc_listen_error;
+	pthread_mutex_unlock(&moc_listen_mutex);
+	return moc_listen_reply(fd, err);
+}
+
+/* Reads the lines of a connection until it is closed or fails,
+ * refusing the lines too long without applying any part of them. */
+static void moc_listen_client(int fd) {
+	char line[MOC_LISTEN_MAXLINE];
+	size_t len;
+	ssize_t n;
+	int toolong, ret;
+	char c;
+	len = 0;
+	toolong = 0;
+	while ((n = read(fd, &c, 1)) == 1) {
+		if (c != '\n') {
+			if (len < sizeof(line) - 1) {
+				line[len++] = c;
+			} else {
+				toolong = 1;
+			}
+			continue;
+		}
+		line[len] = '\0';
+		ret = toolong ? moc_listen_reply(fd, "line too long")
+			: moc_listen_apply(fd, line);
+		len = 0;
+		toolong = 0;
+		if (ret != 0) {
+			break;
+		}
+	}
+}
+
+static void *moc_listen_thread(void *arg) {
+	int sock, fd;
+	sock = *(int *) arg;
+	while ((fd = accept(sock, NULL, NULL)) >= 0) {
+		moc_listen_client(fd);
+		close(fd);
+	}
+	return NULL;
+}
+
+int moc_listen(const char *path) {
+	static int sock;
+	struct sockaddr_un addr;
+	pthread_t thread;
+	if (strlen(path) >= sizeof(addr.sun_path)) {
+		return -1;
+	}
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	strcpy(addr.sun_path, path);
+	unlink(path);
+	sock = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (sock < 0) {
+		return -1;
+	}
+	if (bind(sock, (struct sockaddr *) &addr, sizeof(addr)) != 0
+			|| listen(sock, 1) != 0
+			|| pthread_create(&thread, NULL, moc_listen_thread,
+				&sock) != 0) {
+		close(sock);
+		return -1;
+	}
+	pthread_detach(thread);
+	moc_set_pollfn(moc_listen_poll);
+	return 0;
+}
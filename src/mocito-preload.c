@@ -0,0 +1,228 @@
+/*
+   Mocito is a mocking library for writing unit tests of C code.
+   Copyright (C) 2025 Carlos Rica Espinosa <jasampler@gmail.com>
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software Foundation,
+   Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+*/
+
+/*
+ * Library for LD_PRELOAD that replaces some functions of the C library
+ * with mocks, for mocking the time, the random numbers, the environment
+ * and the input/output of programs that cannot be modified.
+ *
+ * Unlike the rest of Mocito this file depends on a POSIX system with
+ * dlsym(RTLD_NEXT) and a GCC compatible compiler, and must be built
+ * as a shared library together with Mocito and the setup file:
+ *
+ *   cc -shared -fPIC -O2 -Iinclude -o libmocito-preload.so \
+ *       src/mocito-preload.c src/mocito.c setup.c -ldl
+ *   LD_PRELOAD=./libmocito-preload.so ./program
+ *
+ * The setup file must define moc_preload_setup(), which is called when
+ * the library is loaded for adding the mappings of the mocked functions
+ * with moc_given() or moc_attach_table(), using the names of the C
+ * library functions and the types given below for each function.
+ * The functions without mappings call to the real functions, and so do
+ * the calls that no mapping matches, instead of reporting an error.
+ *
+ * The mocks are not thread-safe: the configuration and the handles of
+ * the functions are shared without locks, so the programs that call to
+ * the mocked functions from several threads at the same time can get
+ * wrong results.
+ */
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include "mocito.h"
+#include <dlfcn.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/time.h>
+
+/* Size of the memory for the configurations of the mocks. */
+#ifndef MOC_PRELOAD_MEMSIZE
+#define MOC_PRELOAD_MEMSIZE 65536
+#endif
+
+/* Called when the library is loaded for configuring the mocks. */
+void moc_preload_setup(void) __attribute__((weak));
+
+static char moc_preload_mem[MOC_PRELOAD_MEMSIZE];
+
+/* Error function configured by the setup, and if the last call to a mock
+ * had no mappings matching it: */
+static moc_errfn_t moc_preload_errfn;
+static int moc_preload_nomatch;
+
+/* Real functions, resolved only once when the library is loaded: */
+static time_t (*real_time)(time_t *);
+static clock_t (*real_clock)(void);
+static int (*real_gettimeofday)(struct timeval *, void *);
+static int (*real_rand)(void);
+static char *(*real_getenv)(const char *);
+static ssize_t (*real_read)(int, void *, size_t);
+static ssize_t (*real_write)(int, const void *, size_t);
+
+static void moc_preload_resolve(void) {
+	*(void **) &real_time = dlsym(RTLD_NEXT, "time");
+	*(void **) &real_clock = dlsym(RTLD_NEXT, "clock");
+	*(void **) &real_gettimeofday = dlsym(RTLD_NEXT, "gettimeofday");
+	*(void **) &real_rand = dlsym(RTLD_NEXT, "rand");
+	*(void **) &real_getenv = dlsym(RTLD_NEXT, "getenv");
+	*(void **) &real_read = dlsym(RTLD_NEXT, "read");
+	*(void **) &real_write = dlsym(RTLD_NEXT, "write");
+}
+
+/* Reports the mocking-related errors without calling to the mocks. */
+void moc_error(void) {
+	const char *msg;
+	msg = moc_errmsg();
+	real_write(2, msg, strlen(msg));
+	real_write(2, "\n", 1);
+	abort();
+}
+
+/* Remembers the calls that no mapping matched for calling to the real
+ * function, reporting the rest of errors. */
+static void moc_preload_miss(void) {
+	if (moc_err_nomatch()) {
+		moc_preload_nomatch = 1;
+	} else {
+		moc_preload_errfn();
+	}
+}
+
+__attribute__((constructor))
+static void moc_preload_init(void) {
+	if (real_write == NULL) {
+		moc_preload_resolve();
+	}
+	moc_init(moc_preload_mem, sizeof(moc_preload_mem));
+	if (moc_preload_setup != NULL) {
+		moc_preload_setup();
+	}
+	moc_preload_errfn = moc_get_errfn();
+	moc_set_errfn(&moc_preload_miss);
+}
+
+/* The functions called by other libraries before loading this one
+ * resolve the real functions themselves. */
+#define MOC_PRELOAD_REAL(fn) \
+	if (real_##fn == NULL) moc_preload_resolve()
+
+/* Calls to the mock, returning from the calling function with the
+ * result of the real one when no mapping matches the call. */
+#define MOC_PRELOAD_ACT(val, act, realcall) \
+	moc_preload_nomatch = 0; \
+	val = act; \
+	if (moc_preload_nomatch) return realcall
+
+time_t time(time_t *tloc) {
+	static struct moc_handle moc_hnd = MOC_HANDLE(time);
+	struct moc_value v;
+	time_t t;
+	MOC_PRELOAD_REAL(time);
+	if (! moc_has_mappings(&moc_hnd, 1)) {
+		return real_time(tloc);
+	}
+	MOC_PRELOAD_ACT(v, moc_act_h(&moc_hnd, moc_type_l(),
+			moc_values_1(moc_p((void *) tloc))), real_time(tloc));
+	t = (time_t) moc_get_l(v);
+	if (tloc != NULL) {
+		*tloc = t;
+	}
+	return t;
+}
+
+clock_t clock(void) {
+	static struct moc_handle moc_hnd = MOC_HANDLE(clock);
+	struct moc_value v;
+	MOC_PRELOAD_REAL(clock);
+	if (! moc_has_mappings(&moc_hnd, 0)) {
+		return real_clock();
+	}
+	MOC_PRELOAD_ACT(v, moc_act_h(&moc_hnd, moc_type_l(),
+			moc_values_0()), real_clock());
+	return (clock_t) moc_get_l(v);
+}
+
+int gettimeofday(struct timeval *tv, void *tz) {
+	static struct moc_handle moc_hnd = MOC_HANDLE(gettimeofday);
+	struct moc_value v;
+	MOC_PRELOAD_REAL(gettimeofday);
+	if (! moc_has_mappings(&moc_hnd, 2)) {
+		return real_gettimeofday(tv, tz);
+	}
+	MOC_PRELOAD_ACT(v, moc_act_h(&moc_hnd, moc_type_i(),
+			moc_values_2(moc_p((void *) tv), moc_p(tz))),
+			real_gettimeofday(tv, tz));
+	return moc_get_i(v);
+}
+
+int rand(void) {
+	static struct moc_handle moc_hnd = MOC_HANDLE(rand);
+	struct moc_value v;
+	MOC_PRELOAD_REAL(rand);
+	if (! moc_has_mappings(&moc_hnd, 0)) {
+		return real_rand();
+	}
+	MOC_PRELOAD_ACT(v, moc_act_h(&moc_hnd, moc_type_i(),
+			moc_values_0()), real_rand());
+	return moc_get_i(v);
+}
+
+char *getenv(const char *name) {
+	static struct moc_handle moc_hnd = MOC_HANDLE(getenv);
+	struct moc_value v;
+	MOC_PRELOAD_REAL(getenv);
+	if (! moc_has_mappings(&moc_hnd, 1)) {
+		return real_getenv(name);
+	}
+	MOC_PRELOAD_ACT(v, moc_act_h(&moc_hnd, moc_type_p_c(),
+			moc_values_1(moc_cp_c(name))), real_getenv(name));
+	return moc_get_p_c(v);
+}
+
+ssize_t read(int fd, void *buf, size_t count) {
+	static struct moc_handle moc_hnd = MOC_HANDLE(read);
+	struct moc_value v;
+	MOC_PRELOAD_REAL(read);
+	if (! moc_has_mappings(&moc_hnd, 3)) {
+		return real_read(fd, buf, count);
+	}
+	MOC_PRELOAD_ACT(v, moc_act_h(&moc_hnd, moc_type_l(),
+			moc_values_3(moc_i(fd), moc_p(buf),
+					moc_ul((unsigned long) count))),
+			real_read(fd, buf, count));
+	return (ssize_t) moc_get_l(v);
+}
+
+ssize_t write(int fd, const void *buf, size_t count) {
+	static struct moc_handle moc_hnd = MOC_HANDLE(write);
+	struct moc_value v;
+	MOC_PRELOAD_REAL(write);
+	if (! moc_has_mappings(&moc_hnd, 3)) {
+		return real_write(fd, buf, count);
+	}
+	MOC_PRELOAD_ACT(v, moc_act_h(&moc_hnd, moc_type_l(),
+			moc_values_3(moc_i(fd), moc_cp(buf),
+					moc_ul((unsigned long) count))),
+			real_write(fd, buf, count));
+	return (ssize_t) moc_get_l(v);
+}
@@ -21,6 +21,9 @@
  * Implementation of the Mocito C mocking library for writing tests.
  */
 
+/* The library defines the functions that the header can inline. */
+#undef MOC_INLINE
+
 #include "mocito.h"
 
 /* Remove this definition to run tests of internal functions. */
@@ -39,6 +42,12 @@
 #define MOC_ERR_MAPNOTFND 11 /* no mappings matched for call */
 #define MOC_ERR_INVALMTCH 12 /* invalid place for matcher */
 #define MOC_ERR_INVNPARAM 13 /* invalid parameter number */
+#define MOC_ERR_INVALCMND 14 /* invalid command */
+#define MOC_ERR_NSTRLIMIT 15 /* insufficient memory for strings */
+#define MOC_ERR_INVALTRAN 16 /* invalid state transition */
+#define MOC_ERR_INVALADDR 17 /* invalid register address */
+#define MOC_ERR_INVALFRMT 18 /* invalid format of variable arguments */
+#define MOC_ERR_STRCTYPE 19 /* unexpected struct value */
 
 static const char *moc_gerrdesc[] = {
 	/* (UNUSED) */      "",
@@ -54,7 +63,13 @@ static const char *moc_gerrdesc[] = {
 	/* MOC_ERR_FUNNOTFND */ "function not found in mappings",
 	/* MOC_ERR_MAPNOTFND */ "no mappings matched for call",
 	/* MOC_ERR_INVALMTCH */ "invalid place for matcher",
-	/* MOC_ERR_INVNPARAM */ "invalid parameter number"
+	/* MOC_ERR_INVNPARAM */ "invalid parameter number",
+	/* MOC_ERR_INVALCMND */ "invalid command",
+	/* MOC_ERR_NSTRLIMIT */ "insufficient memory for strings",
+	/* MOC_ERR_INVALTRAN */ "invalid state transition",
+	/* MOC_ERR_INVALADDR */ "invalid register address",
+	/* MOC_ERR_INVALFRMT */ "invalid format of variable arguments",
+	/* MOC_ERR_STRCTYPE */ "unexpected struct value"
 };
 
 static const char *moc_gtypenames[] = {
@@ -70,7 +85,8 @@ static const char *moc_gtypenames[] = {
 	"unsigned short",
 	"unsigned int",
 	"unsigned long",
-	"function"
+	"function",
+	"struct"
 };
 
 typedef unsigned char MOC_NUM_T; /* small count of items */
@@ -104,6 +120,8 @@ struct moc_listnode {
 struct moc_ivalue {
 	double data;
 	moc_type type;
+	unsigned short sttag; /* tag of the struct values */
+	unsigned int stsize; /* size of the struct values */
 };
 
 /* Internal matcher structure. */
@@ -114,6 +132,7 @@ struct moc_imatcher {
 		moc_mtcfn_call_t cll;
 	} mtcfn;
 	MOC_OPTS_T mopts;
+	MOC_OPTS_T mfop; /* compiled operation */
 };
 
 /* Internal responder structure. */
@@ -128,31 +147,86 @@ struct moc_iresponder {
 
 /* Mapping structure that stores a list of arrays of responders and an
  * array of matchers having a number of matchers equal to the number of
- * parameters of the function plus the number of extra matchers. */
+ * parameters of the function plus the number of extra matchers, with
+ * the types of the parameters that the matchers check packed in words. */
 struct moc_mapping {
 	struct moc_list lresps;
+	struct moc_listnode *rfirst; /* first responders added */
 	struct moc_matcher *matchers;
+	unsigned long sigmask, sigtypes; /* packed types of the params */
 	MOC_NUM_T nxmatchers;
+	MOC_NUM_T packed; /* if the matchers are valid and packed */
 };
 
-/* Function structure that stores its name, its number of parameters
- * and a list of mappings that connect its matchers and responders. */
+/* Function structure that stores its name, its number of parameters,
+ * a list of mappings that connect its matchers and responders, and its
+ * signature when it is declared with moc_declare. The mappings added
+ * with moc_given_self for an instance are stored in another function
+ * with the same name and the instance. */
 struct moc_function {
 	struct moc_list lmaps;
 	const char *name;
 	MOC_NUM_T nparams;
+	MOC_NUM_T compiled;
+	const moc_type *ptypes; /* declared parameter types, or 0 */
+	moc_type rettype; /* declared return type */
+	const void *self; /* instance of its mappings, or 0 for all */
 };
 
 /* Defines a memory position to mark where a list of nodes ends. */
 static struct moc_listnode moc_nullnode;
 #define MOC_NULL ((void *) &moc_nullnode)
 #define MOC_NULLNODE ((struct moc_listnode *) &moc_nullnode)
+/* Node returned by moc_given_nnn while only computing fingerprints. */
+static struct moc_listnode moc_drynode;
+/* Initial value of the FNV-1a hashes. */
+#define MOC_FNVINIT 2166136261UL
+
+/* Fingerprint of the mappings, that is a 64-bit FNV-1a hash stored in
+ * two 32-bit halves, because C89 has no 64-bit integer type. */
+struct moc_fp {
+	unsigned long hi, lo;
+};
 #define MOC_AUXMAX 7
+#define MOC_SELFMAX 64
+#define MOC_STRMAX 128
+#define MOC_FRMTMAX 32
+#define MOC_FRMTARGS 16
+
+/* Entry of the cache of the functions of the instances, which are
+ * searched only once for each instance and handle after moc_init while
+ * the cache, probed linearly, is not full. */
+struct moc_selfslot {
+	const void *self;
+	const struct moc_handle *handle;
+	unsigned long epoch;
+	MOC_SIZE_T pos; /* function found, or where to continue searching */
+	moc_bool found;
+};
+
+/* Entry of the table of the strings of the commands and of the compiled
+ * commands, found by their hash for reusing the first equal string.
+ * The strings of the store are valid while they are not removed. */
+struct moc_strslot {
+	const char *str;
+	unsigned long epoch;
+	unsigned long end; /* length of the store with it, or 0 */
+};
+
+/* Entry of the cache of the formats of the variable arguments, which are
+ * parsed only once for each format pointer after moc_init. */
+struct moc_frmtslot {
+	const char *format;
+	unsigned long epoch;
+	moc_type types[MOC_FRMTARGS];
+	unsigned char ntypes;
+};
 
 /* The context groups all the global variables used by Mocito. */
 struct moc_context {
 	struct moc_error_t lasterr;
 	moc_errfn_t errfn;
+	unsigned long nerrors; /* number of errors reported */
 	struct moc_matcher auxmatcs[MOC_AUXMAX];
 	struct moc_matcher auxxmatcs[MOC_AUXMAX];
 	struct moc_responder auxresps[MOC_AUXMAX];
@@ -167,6 +241,38 @@ struct moc_context {
 	MOC_SIZE_T maxmatcs, nmatcs;
 	MOC_SIZE_T maxresps, nresps;
 	MOC_SIZE_T maxlnods, nlnods;
+	MOC_SIZE_T initlnods; /* maxlnods before copying the structs */
+	const struct moc_tblrow *tblrows;
+	unsigned int ntblrows;
+	unsigned long tblstamp; /* changed when the table is attached */
+	moc_bool polled; /* if moc_has_mappings polled for the next call */
+	unsigned int depth; /* number of calls being dispatched */
+	unsigned long epoch; /* number of calls to moc_init */
+	moc_clockfn_t clockfn;
+	struct moc_spy *curspy; /* spy executed in the current call */
+	unsigned long spytime; /* time of the real function of curspy */
+	unsigned long callstart; /* time of the start of the current call */
+	moc_bool started; /* if callstart was read for the next moc_act_f */
+	char *store; /* memory for the strings of the commands */
+	unsigned long storesize, storelen;
+	const struct moc_scenario *scenarios;
+	unsigned int nscenarios;
+	moc_pollfn_t pollfn;
+	struct moc_fp fingerprint; /* of the mappings added */
+	void (*reusefn)(void); /* setup of the mappings for moc_reuse */
+	struct moc_fp reusefp; /* fingerprint after reusefn */
+	moc_bool dryrun; /* if moc_given only computes the fingerprint */
+	moc_bool trusted; /* if the calls of declared functions are trusted */
+	const struct moc_region *regions; /* sorted by start */
+	unsigned int nregions;
+	int callerid; /* region of the caller of the current call or -1 */
+	int nextcaller; /* region set for the next call or -1 */
+	const void *self; /* instance of the mappings being added */
+	struct moc_selfslot selfcache[MOC_SELFMAX];
+	struct moc_strslot strtable[MOC_STRMAX];
+	const struct moc_usertype *usertypes;
+	unsigned int nusertypes;
+	struct moc_frmtslot frmtcache[MOC_FRMTMAX];
 };
 
 static struct moc_context moc_ctx;
@@ -190,7 +296,7 @@ const unsigned int *moc_memstats(void) {
 /* The type of a value is defined by a standard (and a pointer) type. */
 enum moc_stdtype {
 	MOC_VOID, MOC_CHR, MOC_SHR, MOC_INT, MOC_LNG, MOC_FLT, MOC_DBL,
-	MOC_SCHR, MOC_UCHR, MOC_USHR, MOC_UINT, MOC_ULNG, MOC_FUN
+	MOC_SCHR, MOC_UCHR, MOC_USHR, MOC_UINT, MOC_ULNG, MOC_FUN, MOC_STC
 };
 
 /* The type of a value is defined by a pointer (and a standard) type. */
@@ -290,6 +396,38 @@ static unsigned long moc_substridx(const char *str, const char *substr) {
 	return i;
 }
 
+/* Mixes the bytes in the 32-bit FNV-1a hash. */
+static unsigned long moc_fnv(unsigned long hash, const void *bytes,
+		unsigned long n) {
+	const unsigned char *p;
+	for (p = (const unsigned char *) bytes; n > 0; n--, p++) {
+		hash = ((hash ^ *p) * 16777619UL) & 0xFFFFFFFFUL;
+	}
+	return hash;
+}
+
+/* Initializes the fingerprint with the FNV-1a offset basis. */
+static void moc_fpinit(struct moc_fp *fp) {
+	fp->hi = 0xCBF29CE4UL;
+	fp->lo = 0x84222325UL;
+}
+
+/* Mixes the bytes in the fingerprint with the 64-bit FNV-1a hash. */
+static void moc_fpmix(struct moc_fp *fp, const void *bytes,
+		unsigned long n) {
+	const unsigned char *p;
+	unsigned long lo, p0, p1;
+	for (p = (const unsigned char *) bytes; n > 0; n--, p++) {
+		lo = fp->lo ^ *p;
+		/* Multiplies by the prime 2^40 + 0x1B3 in 16-bit parts: */
+		p0 = (lo & 0xFFFFUL) * 0x1B3UL;
+		p1 = (lo >> 16) * 0x1B3UL + (p0 >> 16);
+		fp->lo = (p1 & 0xFFFFUL) << 16 | (p0 & 0xFFFFUL);
+		fp->hi = (fp->hi * 0x1B3UL + (p1 >> 16) + (lo << 8))
+			& 0xFFFFFFFFUL;
+	}
+}
+
 /* Initializes the pointed error structure with the given data. */
 static void moc_init_error_t(struct moc_error_t *e, unsigned char errnum,
 		const char *funcname, MOC_SIZE_T pos,
@@ -308,6 +446,7 @@ static void moc_send_error(unsigned char errnum,
 		moc_type acttype, moc_type exptype) {
 	moc_init_error_t(&(moc_ctx.lasterr), errnum, funcname, pos,
 			acttype, exptype);
+	moc_ctx.nerrors++;
 	moc_ctx.errfn();
 }
 
@@ -383,6 +522,13 @@ static void moc_test_substridx(void) {
 	assert(moc_substridx("eeff", "ffg") == 4);
 }
 
+static void moc_test_fpmix(void) {
+	struct moc_fp fp;
+	moc_fpinit(&fp);
+	moc_fpmix(&fp, "foobar", 6);
+	assert(fp.hi == 0x85944171UL && fp.lo == 0xF73967E8UL);
+}
+
 static void moc_test_errmsg(void) {
 	moc_init_error_t(&(moc_ctx.lasterr), MOC_ERR_NFUNLIMIT, "f1", 0,
 			0, 0);
@@ -404,17 +550,23 @@ static void moc_test_errmsg(void) {
 				moc_type_l(), moc_type_ul());
 	assert(0 == moc_strcmp(moc_errmsg(),
 		"unexpected return type: f5: (long)<>(unsigned long)"));
+	moc_init_error_t(&(moc_ctx.lasterr), MOC_ERR_INVALFRMT, "f6", 2,
+			0, 0);
+	assert(0 == moc_strcmp(moc_errmsg(),
+		"invalid format of variable arguments: f6 (2)"));
 }
 #endif
 
 void moc_init(char *mem, unsigned long size) {
 	char *restmem;
 	moc_ctx.errfn = moc_error;
+	moc_ctx.clockfn = 0;
 	moc_ctx.maxfuncs = size / (5 * sizeof(struct moc_function));
 	moc_ctx.maxmaps = size / (5 * sizeof(struct moc_mapping));
 	moc_ctx.maxmatcs = size / (5 * sizeof(struct moc_matcher));
 	moc_ctx.maxresps = size / (5 * sizeof(struct moc_responder));
 	moc_ctx.maxlnods = size / (5 * sizeof(struct moc_listnode));
+	moc_ctx.initlnods = moc_ctx.maxlnods;
 	moc_ctx.nfuncs = moc_ctx.nmaps = moc_ctx.nmatcs =
 		moc_ctx.nresps = moc_ctx.nlnods = 0;
 	restmem = mem;
@@ -427,12 +579,33 @@ void moc_init(char *mem, unsigned long size) {
 	moc_ctx.resps = (struct moc_responder *) restmem;
 	restmem += moc_ctx.maxresps * sizeof(struct moc_responder);
 	moc_ctx.lnods = (struct moc_listnode *) restmem;
+	moc_ctx.tblrows = 0;
+	moc_ctx.ntblrows = 0;
+	moc_ctx.tblstamp++;
+	moc_ctx.polled = moc_false;
+	moc_ctx.depth = 0;
+	moc_ctx.started = moc_false;
+	moc_ctx.epoch++;
+	moc_ctx.store = 0;
+	moc_ctx.storesize = moc_ctx.storelen = 0;
+	moc_ctx.scenarios = 0;
+	moc_ctx.nscenarios = 0;
+	moc_fpinit(&(moc_ctx.fingerprint));
+	moc_ctx.reusefn = 0;
+	moc_ctx.dryrun = moc_false;
+	moc_ctx.trusted = moc_false;
+	moc_ctx.regions = 0;
+	moc_ctx.nregions = 0;
+	moc_ctx.callerid = moc_ctx.nextcaller = -1;
+	moc_ctx.usertypes = 0;
+	moc_ctx.nusertypes = 0;
 #ifndef MOC_NOTESTS
 	moc_test_size();
 	moc_test_itostr();
 	moc_test_strncpy();
 	moc_test_substridx();
 	moc_test_errmsg();
+	moc_test_fpmix();
 #endif
 }
 
@@ -440,6 +613,19 @@ void moc_set_errfn(moc_errfn_t errfn) {
 	moc_ctx.errfn = errfn;
 }
 
+moc_errfn_t moc_get_errfn(void) {
+	return moc_ctx.errfn;
+}
+
+moc_bool moc_err_nomatch(void) {
+	return moc_ctx.lasterr.errnum == MOC_ERR_FUNNOTFND
+		|| moc_ctx.lasterr.errnum == MOC_ERR_MAPNOTFND;
+}
+
+void moc_set_clock(moc_clockfn_t clockfn) {
+	moc_ctx.clockfn = clockfn;
+}
+
 #define MOC_IVAL(pvalue)       ((struct moc_ivalue *) (pvalue))
 #define MOC_VALBYTE(value)    (MOC_IVAL(&(value))->type)
 #define MOC_STDTYPE(byte)     ((enum moc_stdtype) (((int) (byte)) / 4))
@@ -458,7 +644,7 @@ static void moc_type2str(char *dest, unsigned short type) {
 	int stdtype, ptrtype;
 	stdtype = MOC_STDTYPE(type);
 	ptrtype = MOC_PTRTYPE(type);
-	if (stdtype <= MOC_FUN) {
+	if (stdtype <= MOC_STC) {
 		moc_strncpy(dest + n, "(", 2);
 		n++;
 		if (ptrtype == MOC_CPTR) {
@@ -486,9 +672,9 @@ const char *moc_errmsg(void) {
 	e = &(moc_ctx.lasterr);
 	if(e->errmsg[0] == '\0') {
 		n = 0;
-		if (e->errnum <= MOC_ERR_INVNPARAM) {
+		if (e->errnum < sizeof(moc_gerrdesc) / sizeof(*moc_gerrdesc)) {
 			moc_strncpy(e->errmsg + n,
-					moc_gerrdesc[e->errnum], 35);
+					moc_gerrdesc[e->errnum], 40);
 		}
 		n += moc_strlen(e->errmsg + n);
 		moc_strncpy(e->errmsg + n, ": ", 3);
@@ -1155,6 +1341,106 @@ moc_type moc_get_type(struct moc_value value) {
 #define MOC_GET_FN(value) (*(moc_fnptr *)   MOC_VALDATA(value))
 #define MOC_GET_P(value)  (*(void **)       MOC_VALDATA(value))
 #define MOC_GET_CP(value) (*(const void **) MOC_VALDATA(value))
+#define MOC_STBYTE MOC_TYPES2BYTE(MOC_STC, MOC_NOPTR)
+
+moc_type moc_type_st(void) {
+	return MOC_STBYTE;
+}
+
+struct moc_value moc_st(const void *data, unsigned int size,
+		unsigned short tag) {
+	struct moc_value value;
+	MOC_EMPTYVAL(value);
+	MOC_GET_CP(value) = data;
+	MOC_VALBYTE(value) = MOC_STBYTE;
+	MOC_IVAL(&value)->sttag = tag;
+	MOC_IVAL(&value)->stsize = size;
+	return value;
+}
+
+moc_bool moc_get_st(struct moc_value value, void *dest, unsigned int size,
+		unsigned short tag) {
+	const unsigned char *src;
+	const char *name;
+	unsigned char *d;
+	unsigned int i;
+	if (MOC_VALBYTE(value) != MOC_STBYTE) {
+		return moc_false; /* already reported checking the type */
+	}
+	if (MOC_IVAL(&value)->stsize != size
+			|| MOC_IVAL(&value)->sttag != tag) {
+		/* Names the expected struct by its user type, if any: */
+		name = "moc_get_st";
+		for (i = 0; i < moc_ctx.nusertypes; i++) {
+			if (moc_ctx.usertypes[i].tag == tag
+					&& moc_ctx.usertypes[i].size == size) {
+				name = moc_ctx.usertypes[i].name;
+			}
+		}
+		moc_send_error(MOC_ERR_STRCTYPE, name, tag, 0, 0);
+		return moc_false;
+	}
+	src = (const unsigned char *) MOC_GET_CP(value);
+	d = (unsigned char *) dest;
+	for (i = 0; i < size; i++) {
+		d[i] = src[i];
+	}
+	return moc_true;
+}
+
+void moc_set_usertypes(const struct moc_usertype *types,
+		unsigned int ntypes) {
+	moc_ctx.usertypes = types;
+	moc_ctx.nusertypes = ntypes;
+}
+
+/* Returns the user type of the struct value, or 0 if it has none. */
+static const struct moc_usertype *moc_usertype(struct moc_value val) {
+	unsigned int t;
+	for (t = 0; t < moc_ctx.nusertypes; t++) {
+		if (moc_ctx.usertypes[t].tag == MOC_IVAL(&val)->sttag
+				&& moc_ctx.usertypes[t].size
+				== MOC_IVAL(&val)->stsize) {
+			return moc_ctx.usertypes + t;
+		}
+	}
+	return 0;
+}
+
+/* Compares two struct values with the function of their user type or
+ * like memcmp, and the structs of different size or tag are never equal
+ * nor ordered. */
+static moc_bool moc_cmpst(struct moc_value val1, struct moc_value val2,
+		enum moc_op op) {
+	const struct moc_usertype *ut;
+	const unsigned char *b1, *b2;
+	unsigned int i, size;
+	int c;
+	size = MOC_IVAL(&val1)->stsize;
+	if (size != MOC_IVAL(&val2)->stsize
+			|| MOC_IVAL(&val1)->sttag != MOC_IVAL(&val2)->sttag) {
+		return op == MOC_NE;
+	}
+	b1 = (const unsigned char *) MOC_GET_CP(val1);
+	b2 = (const unsigned char *) MOC_GET_CP(val2);
+	ut = moc_usertype(val1);
+	if (ut != 0 && ut->cmp != 0) {
+		c = ut->cmp(b1, b2);
+	} else {
+		for (i = 0; i < size && b1[i] == b2[i]; i++) {
+		}
+		c = i == size ? 0 : b1[i] < b2[i] ? -1 : 1;
+	}
+	switch (op) {
+		case MOC_EQ: return c == 0;
+		case MOC_NE: return c != 0;
+		case MOC_LT: return c < 0;
+		case MOC_LE: return c <= 0;
+		case MOC_GT: return c > 0;
+		case MOC_GE: return c >= 0;
+		default: return moc_false;
+	}
+}
 
 /* Returns moc_true if the given values have equal type and value. */
 static moc_bool moc_values_eq(struct moc_value val1,
@@ -1190,6 +1476,7 @@ static moc_bool moc_values_eq(struct moc_value val1,
 					== moc_get_ul(val2));
 			case MOC_FUN: return (*moc_get_fn(val1)
 					== moc_get_fn(val2));
+			case MOC_STC: return moc_cmpst(val1, val2, MOC_EQ);
 			default: return moc_false;
 		}
 	}
@@ -1313,6 +1600,7 @@ static moc_bool moc_cmpop(struct moc_value val1, struct moc_value val2,
 						MOC_GET_UL(val2), op);
 		case MOC_FUN: return moc_cmpfn(MOC_GET_FN(val1),
 						MOC_GET_FN(val2), op);
+		case MOC_STC: return moc_cmpst(val1, val2, op);
 		default: return moc_false; /* must not arrive here */
 	}
 }
@@ -1341,9 +1629,9 @@ static moc_bool moc_cmpge(struct moc_value val1, struct moc_value val2) {
 	return moc_cmpop(val1, val2, MOC_GE);
 }
 
-/* Maximum number of parameters, used to mark out of range errors.
+/* Number used to mark the parameter numbers out of range (errors).
  * If opts is greater than 127, then type checking is disabled. */
-#define MOC_MAXPARAMS 127
+#define MOC_NOPARAM (MOC_MAXPARAMS + 1)
 
 struct moc_matcher moc_mparam(moc_mtcfn_param_t mtcfn,
 		struct moc_value value) {
@@ -1369,8 +1657,8 @@ struct moc_matcher moc_xparam(int nparam,
 	MOC_IMTC(&m)->mval = value;
 	MOC_IMTC(&m)->mtcfn.prm = mtcfn;
 	MOC_IMTC(&m)->mopts = (MOC_OPTS_T) (nparam <= 0
-			|| nparam >= MOC_MAXPARAMS ?
-				MOC_MAXPARAMS : nparam);
+			|| nparam >= MOC_NOPARAM ?
+				MOC_NOPARAM : nparam);
 	return m;
 }
 
@@ -1380,8 +1668,8 @@ struct moc_matcher moc_xparam_nochk(int nparam,
 	MOC_IMTC(&m)->mval = value;
 	MOC_IMTC(&m)->mtcfn.prm = mtcfn;
 	MOC_IMTC(&m)->mopts = (MOC_OPTS_T) (nparam <= 0
-			|| nparam >= MOC_MAXPARAMS ?
-				MOC_MAXPARAMS : 128 + nparam);
+			|| nparam >= MOC_NOPARAM ?
+				MOC_NOPARAM : 128 + nparam);
 	return m;
 }
 
@@ -1390,7 +1678,7 @@ struct moc_matcher moc_xcall(moc_mtcfn_call_t mtcfn,
 	struct moc_matcher m = moc_emptymtc;
 	MOC_IMTC(&m)->mval = value;
 	MOC_IMTC(&m)->mtcfn.cll = mtcfn;
-	MOC_IMTC(&m)->mopts = 128 + MOC_MAXPARAMS;
+	MOC_IMTC(&m)->mopts = 128 + MOC_NOPARAM;
 	return m;
 }
 
@@ -1688,8 +1976,8 @@ struct moc_responder moc_rparam(int nparam,
 	MOC_IRSP(&r)->rspfn.prm = rspfn;
 	MOC_IRSP(&r)->rval = val;
 	MOC_IRSP(&r)->ropts = (MOC_OPTS_T) (nparam <= 0
-			|| nparam >= MOC_MAXPARAMS ?
-				MOC_MAXPARAMS : nparam);
+			|| nparam >= MOC_NOPARAM ?
+				MOC_NOPARAM : nparam);
 	return r;
 }
 
@@ -1699,8 +1987,8 @@ struct moc_responder moc_rparam_nochk(int nparam,
 	MOC_IRSP(&r)->rspfn.prm = rspfn;
 	MOC_IRSP(&r)->rval = val;
 	MOC_IRSP(&r)->ropts = (MOC_OPTS_T) (nparam <= 0
-			|| nparam >= MOC_MAXPARAMS ?
-				MOC_MAXPARAMS : 128 + nparam);
+			|| nparam >= MOC_NOPARAM ?
+				MOC_NOPARAM : 128 + nparam);
 	return r;
 }
 
@@ -1709,7 +1997,7 @@ struct moc_responder moc_rcall(moc_rspfn_call_t rspfn,
 	struct moc_responder r = moc_emptyrsp;
 	MOC_IRSP(&r)->rspfn.cll = rspfn;
 	MOC_IRSP(&r)->rval = val;
-	MOC_IRSP(&r)->ropts = 128 + MOC_MAXPARAMS;
+	MOC_IRSP(&r)->ropts = 128 + MOC_NOPARAM;
 	return r;
 }
 
@@ -1749,6 +2037,456 @@ struct moc_responder moc_count(struct moc_value ptr) {
 	return moc_rcall(&moc_rspinc, ptr);
 }
 
+void moc_init_spy(struct moc_spy *spy, moc_rspfn_call_t realfn) {
+	unsigned char i;
+	spy->realfn = realfn;
+	spy->ncalls = 0;
+	spy->nparams = 0;
+	for (i = 0; i < MOC_SPYMAXPARAMS; i++) {
+		spy->params[i] = moc_emptyval;
+	}
+	spy->result = moc_emptyval;
+	spy->realtime = 0;
+	spy->moctime = 0;
+	spy->rec = 0;
+	spy->outparam = 0;
+	spy->lenparam = 0;
+}
+
+/* Traces of calls recorded by the spies have a header and one record
+ * per call with the numbers as little-endian bytes and the values as
+ * the bytes of their data (in the byte order of the host) and type,
+ * excepting the strings:
+ *   name NUL, nparams, nparams x (kind, value or u16 len string NUL),
+ *   result value, outparam, (u32 len, data if outparam is not 0). */
+#define MOC_TRACEHDR "MOCT\1"
+#define MOC_TRACEHDRLEN 5
+#define MOC_TRACEVALLEN (sizeof(double) + 1)
+#define MOC_TRACERAW 0 /* value with its data */
+#define MOC_TRACESTR 1 /* const char * string */
+#define MOC_REPLAYMAX 64 /* calls with strings found by hash in a replay */
+
+void moc_init_recorder(struct moc_recorder *rec, char *buf,
+		unsigned long size) {
+	unsigned long i;
+	rec->buf = buf;
+	rec->size = size;
+	rec->len = 0;
+	rec->nlost = 0;
+	if (size >= MOC_TRACEHDRLEN) {
+		for (i = 0; i < MOC_TRACEHDRLEN; i++) {
+			buf[i] = MOC_TRACEHDR[i];
+		}
+		rec->len = MOC_TRACEHDRLEN;
+	}
+}
+
+void moc_spy_record(struct moc_spy *spy, struct moc_recorder *rec,
+		int outparam, int lenparam) {
+	spy->rec = rec;
+	spy->outparam = (unsigned char) (outparam > 0
+			&& outparam <= MOC_SPYMAXPARAMS ? outparam : 0);
+	spy->lenparam = (unsigned char) (lenparam > 0
+			&& lenparam <= MOC_SPYMAXPARAMS ? lenparam : 0);
+}
+
+/* Writes the bytes in the trace if they fit, advancing the position. */
+static moc_bool moc_recput(struct moc_recorder *rec, unsigned long *pos,
+		const void *bytes, unsigned long n) {
+	unsigned long i;
+	if (*pos > rec->size || rec->size - *pos < n) {
+		return moc_false;
+	}
+	for (i = 0; i < n; i++) {
+		rec->buf[*pos + i] = ((const char *) bytes)[i];
+	}
+	*pos += n;
+	return moc_true;
+}
+
+/* Writes a number in the given number of little-endian bytes. */
+static moc_bool moc_recnum(struct moc_recorder *rec, unsigned long *pos,
+		unsigned long num, unsigned int nbytes) {
+	unsigned char bytes[4];
+	unsigned int i;
+	for (i = 0; i < nbytes; i++) {
+		bytes[i] = (unsigned char) ((num >> (8 * i)) & 0xFF);
+	}
+	return moc_recput(rec, pos, bytes, nbytes);
+}
+
+/* Writes a value, refusing the structs whose bytes are not stored. */
+static moc_bool moc_recval(struct moc_recorder *rec, unsigned long *pos,
+		struct moc_value val) {
+	return MOC_VALBYTE(val) != MOC_STBYTE
+		&& moc_recput(rec, pos, MOC_VALDATA(val), sizeof(double))
+		&& moc_recput(rec, pos, &MOC_VALBYTE(val), 1);
+}
+
+/* Returns the value of an integer type as unsigned long or 0. */
+static unsigned long moc_valtoul(struct moc_value val) {
+	long l;
+	if (MOC_VALPTRTYPE(val) != MOC_NOPTR) {
+		return 0;
+	}
+	switch (MOC_VALSTDTYPE(val)) {
+		case MOC_CHR: l = moc_get_c(val); break;
+		case MOC_SHR: l = moc_get_s(val); break;
+		case MOC_INT: l = moc_get_i(val); break;
+		case MOC_LNG: l = moc_get_l(val); break;
+		case MOC_SCHR: l = moc_get_sc(val); break;
+		case MOC_UCHR: return moc_get_uc(val);
+		case MOC_USHR: return moc_get_us(val);
+		case MOC_UINT: return moc_get_ui(val);
+		case MOC_ULNG: return moc_get_ul(val);
+		default: return 0;
+	}
+	return l < 0 ? 0 : (unsigned long) l;
+}
+
+/* Records a call of the spy, completely or not at all. */
+static void moc_reccall(struct moc_spy *spy, struct moc_call *call) {
+	struct moc_recorder *rec;
+	struct moc_value val;
+	const char *str;
+	unsigned long pos, n;
+	unsigned char i, kind;
+	moc_bool ok;
+	rec = spy->rec;
+	pos = rec->len;
+	ok = moc_recput(rec, &pos, call->funcname,
+			moc_strlen(call->funcname) + 1)
+		&& moc_recnum(rec, &pos, call->nparams, 1);
+	for (i = 0; ok && i < call->nparams; i++) {
+		val = call->params[i];
+		kind = MOC_TRACERAW;
+		str = (const char *) MOC_GET_CP(val);
+		if (str != 0 && MOC_VALBYTE(val) == MOC_TYPES2BYTE(MOC_CHR,
+				MOC_CPTR) && moc_strlen(str) <= 0xFFFF) {
+			kind = MOC_TRACESTR;
+		}
+		ok = moc_recnum(rec, &pos, kind, 1);
+		if (ok && kind == MOC_TRACERAW) {
+			ok = moc_recval(rec, &pos, val);
+		} else if (ok) {
+			n = moc_strlen(str);
+			ok = moc_recnum(rec, &pos, n, 2)
+				&& moc_recput(rec, &pos, str, n + 1);
+		}
+	}
+	ok = ok && moc_recval(rec, &pos, spy->result)
+		&& moc_recnum(rec, &pos, spy->outparam <= call->nparams
+				? spy->outparam : 0, 1);
+	if (ok && spy->outparam != 0 && spy->outparam <= call->nparams) {
+		n = moc_valtoul(spy->lenparam != 0
+				&& spy->lenparam <= call->nparams
+				? call->params[spy->lenparam - 1] : spy->result);
+		if (MOC_VALPTRTYPE(call->params[spy->outparam - 1]) == MOC_NOPTR
+				|| MOC_GET_CP(call->params[spy->outparam - 1])
+					== 0) {
+			n = 0;
+		}
+		ok = moc_recnum(rec, &pos, n, 4) && moc_recput(rec, &pos,
+				MOC_GET_CP(call->params[spy->outparam - 1]), n);
+	}
+	if (ok) {
+		rec->len = pos;
+	} else {
+		rec->nlost++;
+	}
+}
+
+static struct moc_value moc_rspspy(struct moc_call *call,
+		struct moc_value val) {
+	struct moc_spy *spy;
+	unsigned long start;
+	unsigned char i;
+	spy = (struct moc_spy *) moc_get_p(val);
+	spy->ncalls++;
+	spy->nparams = call->nparams < MOC_SPYMAXPARAMS ? call->nparams
+		: MOC_SPYMAXPARAMS;
+	for (i = 0; i < spy->nparams; i++) {
+		spy->params[i] = call->params[i];
+	}
+	if (moc_ctx.clockfn == 0) {
+		spy->result = spy->realfn(call, val);
+	} else {
+		start = moc_ctx.clockfn();
+		spy->result = spy->realfn(call, val);
+		/* The time of the real function is not in moctime: */
+		moc_ctx.spytime = moc_ctx.clockfn() - start;
+		spy->realtime += moc_ctx.spytime;
+		moc_ctx.curspy = spy;
+	}
+	if (spy->rec != 0) {
+		moc_reccall(spy, call);
+	}
+	return spy->result;
+}
+
+struct moc_responder moc_spy(struct moc_spy *spy) {
+	return moc_rcall(&moc_rspspy, moc_p(spy));
+}
+
+/* Reader of a trace that checks the length of each read. */
+struct moc_reader {
+	const unsigned char *p;
+	unsigned long left;
+};
+
+static const unsigned char *moc_rdbytes(struct moc_reader *rd,
+		unsigned long n) {
+	const unsigned char *p;
+	if (rd->left < n) {
+		rd->left = 0;
+		rd->p = 0;
+		return 0;
+	}
+	p = rd->p;
+	rd->p += n;
+	rd->left -= n;
+	return p;
+}
+
+static unsigned long moc_rdnum(struct moc_reader *rd, unsigned int nbytes) {
+	const unsigned char *p;
+	unsigned long num = 0;
+	unsigned int i;
+	p = moc_rdbytes(rd, nbytes);
+	for (i = 0; p != 0 && i < nbytes; i++) {
+		num |= (unsigned long) p[i] << (8 * i);
+	}
+	return num;
+}
+
+static struct moc_value moc_rdval(struct moc_reader *rd) {
+	struct moc_value val;
+	const unsigned char *p;
+	unsigned int i;
+	val = moc_emptyval;
+	p = moc_rdbytes(rd, MOC_TRACEVALLEN);
+	for (i = 0; p != 0 && i < sizeof(double); i++) {
+		((unsigned char *) MOC_VALDATA(val))[i] = p[i];
+	}
+	if (p != 0) {
+		MOC_VALBYTE(val) = p[sizeof(double)];
+	}
+	return val;
+}
+
+/* Reads a string of the trace checking that it ends with NUL. */
+static const char *moc_rdstr(struct moc_reader *rd, unsigned long n) {
+	const unsigned char *p;
+	p = moc_rdbytes(rd, n + 1);
+	if (p == 0 || p[n] != 0) {
+		rd->p = 0;
+		rd->left = 0;
+		return 0;
+	}
+	return (const char *) p;
+}
+
+/* Responder copying the data recorded in the trace to the parameter. */
+static struct moc_value moc_rspcopy(struct moc_value param,
+		struct moc_value data) {
+	const unsigned char *src;
+	unsigned char *dst;
+	unsigned long n, i;
+	src = (const unsigned char *) MOC_GET_CP(data);
+	dst = (unsigned char *) MOC_GET_P(param);
+	n = (unsigned long) src[0] | (unsigned long) src[1] << 8
+		| (unsigned long) src[2] << 16 | (unsigned long) src[3] << 24;
+	for (i = 0; dst != 0 && i < n; i++) {
+		dst[i] = src[4 + i];
+	}
+	return moc_emptyval;
+}
+
+/* Returns the matcher of a recorded parameter: strings are compared
+ * by content, other pointers match any pointer of the same type. */
+static struct moc_matcher moc_rdmtc(struct moc_reader *rd) {
+	struct moc_value val;
+	unsigned long kind;
+	const char *str;
+	kind = moc_rdnum(rd, 1);
+	if (kind == MOC_TRACESTR) {
+		str = moc_rdstr(rd, moc_rdnum(rd, 2));
+		return moc_eq_cstr(str);
+	}
+	val = moc_rdval(rd);
+	if (kind != MOC_TRACERAW || MOC_VALSTDTYPE(val) > MOC_FUN
+			|| MOC_VALPTRTYPE(val) > MOC_CPTR) {
+		rd->p = 0;
+		rd->left = 0;
+	}
+	if (MOC_VALPTRTYPE(val) != MOC_NOPTR) {
+		MOC_GET_CP(val) = 0;
+		return moc_mparam(moc_mtctrue, val);
+	}
+	return moc_eq(val);
+}
+
+/* Returns the name and matchers of the call read, or 0 if invalid. */
+static const char *moc_rdcall(struct moc_reader *rd,
+		struct moc_matcher *matchers, unsigned long *nparams) {
+	const char *name;
+	unsigned long i;
+	name = (const char *) rd->p;
+	for (i = 0; i < rd->left && name[i] != '\0'; i++) {
+		;
+	}
+	if (moc_rdstr(rd, i) == 0) {
+		return 0;
+	}
+	*nparams = moc_rdnum(rd, 1);
+	if (*nparams > MOC_SPYMAXPARAMS) {
+		return 0;
+	}
+	for (i = 0; rd->p != 0 && i < *nparams; i++) {
+		matchers[i] = moc_rdmtc(rd);
+	}
+	return rd->p != 0 ? name : 0;
+}
+
+/* Skips the result and the out data of the record of a call. */
+static void moc_rdskip(struct moc_reader *rd) {
+	moc_rdval(rd);
+	if (moc_rdnum(rd, 1) != 0) {
+		moc_rdbytes(rd, moc_rdnum(rd, 4));
+	}
+}
+
+/* Returns moc_true if some of the matchers compares a string. */
+static moc_bool moc_rdhasstr(const struct moc_matcher *matchers,
+		unsigned long nparams) {
+	unsigned long i;
+	for (i = 0; i < nparams; i++) {
+		if (MOC_VALBYTE(MOC_IMTC(matchers + i)->mval)
+				== MOC_TYPES2BYTE(MOC_CHR, MOC_CPTR)
+				&& MOC_GET_CP(MOC_IMTC(matchers + i)->mval) != 0) {
+			return moc_true;
+		}
+	}
+	return moc_false;
+}
+
+/* Returns moc_true and its matchers if the call of the trace at prev
+ * has the given bytes, which are also valid for it. */
+static moc_bool moc_rdsame(const unsigned char *prev,
+		const unsigned char *start, const unsigned char *end,
+		struct moc_matcher *matchers) {
+	struct moc_matcher prevmatchers[MOC_SPYMAXPARAMS];
+	struct moc_reader rd;
+	unsigned long nparams, i;
+	for (i = 0; start + i < end && prev[i] == start[i]; i++) {
+		;
+	}
+	if (start + i != end) {
+		return moc_false;
+	}
+	rd.p = prev;
+	rd.left = (unsigned long) (end - start);
+	moc_rdcall(&rd, prevmatchers, &nparams);
+	for (i = 0; i < nparams; i++) {
+		matchers[i] = prevmatchers[i];
+	}
+	return moc_true;
+}
+
+/* Searches a previous call of the trace with equal bytes, for using
+ * its matchers, with equal strings, that will be merged in a mapping.
+ * The calls are found by the hash of their bytes in the given table,
+ * and in the whole trace only when the table is full. */
+static void moc_rdprev(const char *trace, const unsigned char *start,
+		const unsigned char *end, struct moc_matcher *matchers,
+		unsigned long nparams, const unsigned char **seen) {
+	struct moc_matcher prevmatchers[MOC_SPYMAXPARAMS];
+	struct moc_reader rd;
+	const unsigned char *prevstart;
+	unsigned long h, n, i;
+	if (! moc_rdhasstr(matchers, nparams)) {
+		return; /* equal matchers without strings are merged */
+	}
+	h = moc_fnv(MOC_FNVINIT, start, (unsigned long) (end - start));
+	for (n = 0; n < MOC_REPLAYMAX; n++) {
+		i = (h + n) % MOC_REPLAYMAX;
+		if (seen[i] == 0) {
+			seen[i] = start; /* first call with these bytes */
+			return;
+		}
+		if (moc_rdsame(seen[i], start, end, matchers)) {
+			return;
+		}
+	}
+	rd.p = (const unsigned char *) trace + MOC_TRACEHDRLEN;
+	rd.left = (unsigned long) (start - rd.p);
+	while (rd.p != 0 && rd.left > 0) {
+		prevstart = rd.p;
+		if (moc_rdcall(&rd, prevmatchers, &n) == 0) {
+			return;
+		}
+		if (rd.p - prevstart == end - start
+				&& moc_rdsame(prevstart, start, end, matchers)) {
+			return;
+		}
+		moc_rdskip(&rd);
+	}
+}
+
+unsigned long moc_replay(const char *trace, unsigned long len) {
+	struct moc_matcher matchers[MOC_SPYMAXPARAMS];
+	const unsigned char *seen[MOC_REPLAYMAX];
+	struct moc_reader rd;
+	struct moc_value result;
+	const char *name;
+	const unsigned char *start;
+	unsigned long nparams, outparam, ncalls, n, nerrors;
+	for (n = 0; n < MOC_TRACEHDRLEN; n++) {
+		if (n >= len || trace[n] != MOC_TRACEHDR[n]) {
+			return 0;
+		}
+	}
+	for (n = 0; n < MOC_REPLAYMAX; n++) {
+		seen[n] = 0;
+	}
+	rd.p = (const unsigned char *) trace + MOC_TRACEHDRLEN;
+	rd.left = len - MOC_TRACEHDRLEN;
+	nerrors = moc_ctx.nerrors;
+	for (ncalls = 0; rd.left > 0; ncalls++) {
+		start = rd.p;
+		name = moc_rdcall(&rd, matchers, &nparams);
+		if (name == 0) {
+			break;
+		}
+		moc_rdprev(trace, start, rd.p, matchers, nparams, seen);
+		result = moc_rdval(&rd);
+		outparam = moc_rdnum(&rd, 1);
+		start = rd.p;
+		if (outparam != 0) {
+			moc_rdbytes(&rd, moc_rdnum(&rd, 4));
+		}
+		if (rd.p == 0 || outparam > nparams) {
+			break;
+		}
+		if (outparam == 0) {
+			moc_given(name, moc_init_matchers_grp(
+					(unsigned char) nparams, matchers),
+					moc_respond_1(moc_return(result)));
+		} else {
+			moc_given(name, moc_init_matchers_grp(
+					(unsigned char) nparams, matchers),
+					moc_respond_2(moc_rparam_nochk(
+						(int) outparam, moc_rspcopy,
+						moc_cp(start)),
+					moc_return(result)));
+		}
+		if (moc_ctx.nerrors != nerrors) {
+			break; /* the call was not added */
+		}
+	}
+	return ncalls;
+}
+
 struct moc_matchers_grp moc_init_matchers_grp(unsigned char nelems,
 		struct moc_matcher *elems) {
 	struct moc_matchers_grp v;
@@ -2126,7 +2864,8 @@ static moc_bool moc_isvalidtype(moc_type type) {
 	stdtype = MOC_STDTYPE(type);
 	ptrtype = MOC_PTRTYPE(type);
 	return (stdtype >= MOC_VOID && stdtype <= MOC_FUN
-			&& ptrtype >= MOC_NOPTR && ptrtype <= MOC_CPTR);
+			&& ptrtype >= MOC_NOPTR && ptrtype <= MOC_CPTR)
+		|| type == MOC_TYPES2BYTE(MOC_STC, MOC_NOPTR);
 }
 
 static moc_bool moc_matchers_eq(struct moc_matcher *m1,
@@ -2150,79 +2889,367 @@ static moc_bool moc_matchers_eq(struct moc_matcher *m1,
 	return moc_true;
 }
 
-static void moc_given_nnn(const char *funcname, MOC_NUM_T nmatchers,
+static moc_bool moc_iscmpfn(struct moc_matcher *mtc) {
+	moc_mtcfn_param_t fn;
+	fn = MOC_IMTC(mtc)->mtcfn.prm;
+	return (fn == moc_cmplt || fn == moc_cmple
+		|| fn == moc_cmpgt || (fn == moc_cmpge
+			? moc_true : moc_false));
+}
+
+/* Returns the number of the error of a matcher that can be detected
+ * without the parameters of the call, or 0 if no error was found. */
+static unsigned char moc_chkmtcpos(struct moc_matcher *pm, int pos,
+		unsigned char nparams) {
+	MOC_OPTS_T opts;
+	moc_type type;
+	opts = MOC_IMTC(pm)->mopts;
+	if ((pos <= nparams && opts != 0 && opts != 128)
+	|| (pos > nparams && (opts == 0 || opts == 128))) {
+		return MOC_ERR_INVALMTCH;
+	}
+	if (pos > nparams && (opts == MOC_NOPARAM
+			|| (opts < MOC_NOPARAM && opts > nparams)
+			|| (opts > 128 && opts < 128 + MOC_NOPARAM
+					&& opts - 128 > nparams))) {
+		return MOC_ERR_INVNPARAM;
+	}
+	type = MOC_VALBYTE(MOC_IMTC(pm)->mval);
+	if (! moc_isvalidtype(type)) {
+		return MOC_ERR_INVALTYPE;
+	}
+	if (type == MOC_TYPES2BYTE(MOC_FUN, MOC_NOPTR)
+			&& moc_iscmpfn(pm)) {
+		return MOC_ERR_INVALOPER;
+	}
+	return 0;
+}
+
+/* Returns the number of the error of a responder that can be detected
+ * without the parameters of the call, or 0 if no error was found. */
+static unsigned char moc_chkrsppos(struct moc_responder *pr,
+		unsigned char nparams) {
+	MOC_OPTS_T opts;
+	opts = MOC_IRSP(pr)->ropts;
+	if (opts == 0 || opts == MOC_NOPARAM
+			|| (opts < MOC_NOPARAM && opts > nparams)
+			|| (opts > 128 && opts < 128 + MOC_NOPARAM
+					&& opts - 128 > nparams)) {
+		return MOC_ERR_INVNPARAM;
+	}
+	if (! moc_isvalidtype(MOC_VALBYTE(MOC_IRSP(pr)->rval))) {
+		return MOC_ERR_INVALTYPE;
+	}
+	return 0;
+}
+
+/* Checks the matchers and responders of a mapping of a declared function
+ * against its signature, reporting the first error found. The matchers
+ * of the parameters are followed by the extra matchers. */
+static moc_bool moc_chkdecl(struct moc_function *func,
 		struct moc_matcher *matchers, MOC_NUM_T nxmatchers,
 		struct moc_matcher *xmatchers, MOC_NUM_T nresponders,
 		struct moc_responder *responders) {
-	struct moc_function *func;
-	struct moc_mapping *map;
-	struct moc_responder *resps;
-	struct moc_listnode *mnode, *rnode;
-	MOC_SIZE_T m, r;
+	struct moc_matcher *pm;
+	struct moc_iresponder *ir;
+	MOC_OPTS_T opts;
 	moc_type type;
-	MOC_SIZE_T nf, f, nfuncsinc = 0, pos;
-	/* Searches the function by name and nparams: */
-	nf = moc_ctx.nfuncs;
-	for (f = 0; f < nf; f++) {
-		if (moc_ctx.funcs[f].nparams == nmatchers
-				&& moc_strcmp(moc_ctx.funcs[f].name,
-					funcname) == 0) {
-			break; /* function found */
+	unsigned char errnum;
+	MOC_SIZE_T m, r, i;
+	for (m = 0; m < func->nparams + nxmatchers; m++) {
+		pm = m < func->nparams ? matchers + m
+			: xmatchers + m - func->nparams;
+		opts = MOC_IMTC(pm)->mopts;
+		type = MOC_VALBYTE(MOC_IMTC(pm)->mval);
+		errnum = moc_chkmtcpos(pm, m + 1, func->nparams);
+		if (errnum != 0) {
+			moc_send_error(errnum, func->name, m + 1,
+					errnum == MOC_ERR_INVALTYPE ? type : 0,
+					errnum == MOC_ERR_INVALTYPE ? type : 0);
+			return moc_false;
 		}
-	}
-	if (f < nf) {
-		/* Searches the mapping node with equal matchers: */
-		func = moc_ctx.funcs + f;
-		mnode = func->lmaps.first;
-		while (mnode != MOC_NULLNODE) {
-			map = (struct moc_mapping *) mnode->item;
-			if (nxmatchers != map->nxmatchers) {
-				mnode = mnode->next;
-				continue;
-			}
-			for (m = 0; m < nmatchers + nxmatchers; m++) {
-				if (! moc_matchers_eq(map->matchers + m,
-						matchers + m)) {
-					break; /* not found */
-				}
-			}
-			if (m == nmatchers + nxmatchers) {
-				break; /* mapping node found */
+		if (m < func->nparams ? opts == 0 : opts < MOC_NOPARAM) {
+			i = m < func->nparams ? m : opts - 1u;
+			if (type != func->ptypes[i]) {
+				moc_send_error(MOC_ERR_PARAMTYPE, func->name,
+						m + 1, func->ptypes[i], type);
+				return moc_false;
 			}
-			mnode = mnode->next;
 		}
-	} else {
-		/* Adds name and nparams to the first free function: */
-		if (nf == moc_ctx.maxfuncs) {
-			moc_send_error(MOC_ERR_NFUNLIMIT, funcname, 0,
-					0, 0);
-			return;
+	}
+	for (r = 0; r < nresponders; r++) {
+		ir = MOC_IRSP(responders + r);
+		opts = ir->ropts;
+		type = MOC_VALBYTE(ir->rval);
+		errnum = moc_chkrsppos(responders + r, func->nparams);
+		if (errnum != 0) {
+			moc_send_error(errnum, func->name, 1 + r + m,
+					errnum == MOC_ERR_INVALTYPE ? type : 0,
+					errnum == MOC_ERR_INVALTYPE ? type : 0);
+			return moc_false;
+		}
+		if (opts < MOC_NOPARAM && type != func->ptypes[opts - 1]) {
+			moc_send_error(MOC_ERR_PARAMTYPE, func->name,
+					1 + r + m, func->ptypes[opts - 1], type);
+			return moc_false;
 		}
-		func = moc_ctx.funcs + nf;
-		func->name = funcname;
-		func->nparams = nmatchers;
-		moc_inilist(&(func->lmaps));
-		mnode = MOC_NULLNODE;
-		nfuncsinc++; /* to remember increasing it */
+	}
+	/* The value of moc_return is known before the calls: */
+	ir = nresponders > 0 ? MOC_IRSP(responders + nresponders - 1) : 0;
+	if (ir != 0 && ir->ropts == 128 + MOC_NOPARAM
+			&& ir->rspfn.cll == moc_rsprt
+			&& MOC_VALBYTE(ir->rval) != func->rettype) {
+		moc_send_error(MOC_ERR_RETURTYPE, func->name, 0,
+				MOC_VALBYTE(ir->rval), func->rettype);
+		return moc_false;
+	}
+	return moc_true;
+}
+
+/* Number of parameter types packed in a word for checking them at once. */
+#define MOC_SIGLEN ((MOC_SIZE_T) sizeof(unsigned long))
+
+/* Packs the types of the parameters compared by the typed matchers of a
+ * new mapping in a word with a mask of the bytes used, if its matchers
+ * are valid and only check the types of the first MOC_SIGLEN parameters,
+ * so the calls can check all the types with a single comparison. */
+static void moc_packsig(struct moc_mapping *map, MOC_NUM_T nparams) {
+	struct moc_matcher *pm;
+	MOC_OPTS_T opts;
+	MOC_SIZE_T m, i;
+	unsigned long mask, bits;
+	map->sigmask = 0;
+	map->sigtypes = 0;
+	map->packed = 0;
+	for (m = 0; m < nparams + map->nxmatchers; m++) {
+		pm = map->matchers + m;
+		if (moc_chkmtcpos(pm, m + 1, nparams) != 0) {
+			return; /* errors will be reported on calls */
+		}
+		opts = MOC_IMTC(pm)->mopts;
+		if (m < nparams ? opts != 0 : opts >= MOC_NOPARAM) {
+			continue; /* the type is not checked */
+		}
+		i = m < nparams ? m : opts - 1u;
+		if (i >= MOC_SIGLEN) {
+			return;
+		}
+		mask = 0xFFUL << (8 * i);
+		bits = (unsigned long) MOC_VALBYTE(MOC_IMTC(pm)->mval)
+			<< (8 * i);
+		if ((map->sigmask & mask) != 0
+				&& (map->sigtypes & mask) != bits) {
+			return; /* different types for the same parameter */
+		}
+		map->sigmask |= mask;
+		map->sigtypes |= bits;
+	}
+	map->packed = 1;
+}
+
+/* Mixes the type and the bytes used by the data of the value. */
+static void moc_fpval(struct moc_fp *fp, struct moc_value val) {
+	const struct moc_usertype *ut;
+	unsigned long n, h;
+	moc_fpmix(fp, &MOC_VALBYTE(val), 1);
+	if (MOC_VALPTRTYPE(val) != MOC_NOPTR) {
+		n = sizeof(void *);
+	} else {
+		switch (MOC_VALSTDTYPE(val)) {
+			case MOC_CHR: case MOC_SCHR: case MOC_UCHR: n = 1; break;
+			case MOC_SHR: case MOC_USHR: n = sizeof(short); break;
+			case MOC_INT: case MOC_UINT: n = sizeof(int); break;
+			case MOC_LNG: case MOC_ULNG: n = sizeof(long); break;
+			case MOC_FLT: n = sizeof(float); break;
+			case MOC_DBL: n = sizeof(double); break;
+			case MOC_FUN: n = sizeof(moc_fnptr); break;
+			case MOC_STC:
+				moc_fpmix(fp, &MOC_IVAL(&val)->sttag,
+						sizeof(unsigned short));
+				ut = moc_usertype(val);
+				if (ut != 0 && ut->hash != 0) {
+					h = ut->hash(MOC_GET_CP(val));
+					moc_fpmix(fp, &h, sizeof(h));
+					return;
+				}
+				moc_fpmix(fp, MOC_GET_CP(val),
+						MOC_IVAL(&val)->stsize);
+				return;
+			default: n = 0; break;
+		}
+	}
+	moc_fpmix(fp, MOC_VALDATA(val), n);
+}
+
+/* Mixes a call to moc_given in the fingerprint of the mappings. */
+static void moc_fpgiven(const char *funcname, MOC_NUM_T nmatchers,
+		struct moc_matcher *matchers, MOC_NUM_T nxmatchers,
+		struct moc_matcher *xmatchers, MOC_NUM_T nresponders,
+		struct moc_responder *responders, moc_bool seq) {
+	struct moc_imatcher *im;
+	struct moc_iresponder *ir;
+	struct moc_fp *fp;
+	unsigned char nums[4];
+	MOC_SIZE_T i;
+	fp = &(moc_ctx.fingerprint);
+	moc_fpmix(fp, funcname, moc_strlen(funcname) + 1);
+	if (moc_ctx.self != 0) {
+		moc_fpmix(fp, &(moc_ctx.self), sizeof(moc_ctx.self));
+	}
+	nums[0] = (unsigned char) nmatchers;
+	nums[1] = (unsigned char) nxmatchers;
+	nums[2] = (unsigned char) nresponders;
+	nums[3] = (unsigned char) seq;
+	moc_fpmix(fp, nums, sizeof(nums));
+	for (i = 0; i < nmatchers + nxmatchers; i++) {
+		im = MOC_IMTC(i < nmatchers ? matchers + i
+				: xmatchers + i - nmatchers);
+		moc_fpmix(fp, &(im->mopts), sizeof(im->mopts));
+		if (im->mopts) {
+			moc_fpmix(fp, &(im->mtcfn.prm), sizeof(im->mtcfn.prm));
+		} else {
+			moc_fpmix(fp, &(im->mtcfn.cll), sizeof(im->mtcfn.cll));
+		}
+		moc_fpval(fp, im->mval);
+	}
+	for (i = 0; i < nresponders; i++) {
+		ir = MOC_IRSP(responders + i);
+		moc_fpmix(fp, &(ir->ropts), sizeof(ir->ropts));
+		if (ir->ropts == 128 + MOC_NOPARAM) {
+			moc_fpmix(fp, &(ir->rspfn.cll), sizeof(ir->rspfn.cll));
+		} else {
+			moc_fpmix(fp, &(ir->rspfn.prm), sizeof(ir->rspfn.prm));
+		}
+		moc_fpval(fp, ir->rval);
+	}
+}
+
+/* Returns the number of list nodes needed for storing the bytes of the
+ * value if it is a struct, or 0 for the other values. */
+static unsigned long moc_stnodes(struct moc_value val) {
+	if (MOC_VALBYTE(val) != MOC_STBYTE) {
+		return 0;
+	}
+	return (MOC_IVAL(&val)->stsize + sizeof(struct moc_listnode) - 1)
+		/ sizeof(struct moc_listnode);
+}
+
+/* Copies the bytes of the struct value to the end of the memory of the
+ * list nodes, which must have enough free nodes, to not depend on the
+ * memory of the caller. */
+static void moc_stcopy(struct moc_value *val) {
+	const unsigned char *src;
+	unsigned char *dest;
+	unsigned int i;
+	if (MOC_VALBYTE(*val) != MOC_STBYTE) {
+		return;
+	}
+	moc_ctx.maxlnods -= moc_stnodes(*val);
+	dest = (unsigned char *) (moc_ctx.lnods + moc_ctx.maxlnods);
+	src = (const unsigned char *) MOC_GET_CP(*val);
+	for (i = 0; i < MOC_IVAL(val)->stsize; i++) {
+		dest[i] = src[i];
+	}
+	MOC_GET_CP(*val) = dest;
+}
+
+/* Adds the responders to the mapping node given or to the mapping with
+ * equal matchers, returning its node or MOC_NULLNODE after an error. */
+static struct moc_listnode *moc_given_nnn(const char *funcname,
+		MOC_NUM_T nmatchers, struct moc_matcher *matchers,
+		MOC_NUM_T nxmatchers, struct moc_matcher *xmatchers,
+		MOC_NUM_T nresponders, struct moc_responder *responders,
+		struct moc_listnode *seqnode) {
+	struct moc_function *func;
+	struct moc_mapping *map;
+	struct moc_responder *resps;
+	struct moc_listnode *mnode, *rnode;
+	MOC_SIZE_T m, r;
+	moc_type type;
+	MOC_SIZE_T nf, f, nfuncsinc = 0, pos;
+	unsigned long nstnodes = 0;
+	if (moc_ctx.dryrun) {
+		moc_fpgiven(funcname, nmatchers, matchers, nxmatchers,
+				xmatchers, nresponders, responders,
+				seqnode != MOC_NULLNODE);
+		return &moc_drynode;
+	}
+	/* Searches the function by name and nparams: */
+	nf = moc_ctx.nfuncs;
+	for (f = 0; f < nf; f++) {
+		if (moc_ctx.funcs[f].nparams == nmatchers
+				&& moc_ctx.funcs[f].self == moc_ctx.self
+				&& moc_strcmp(moc_ctx.funcs[f].name,
+					funcname) == 0) {
+			break; /* function found */
+		}
+	}
+	if (f < nf) {
+		/* Searches the mapping node with equal matchers: */
+		func = moc_ctx.funcs + f;
+		mnode = func->lmaps.first;
+		while (mnode != MOC_NULLNODE && mnode != seqnode) {
+			map = (struct moc_mapping *) mnode->item;
+			if (nxmatchers != map->nxmatchers) {
+				mnode = mnode->next;
+				continue;
+			}
+			for (m = 0; m < nmatchers + nxmatchers; m++) {
+				if (! moc_matchers_eq(map->matchers + m,
+						matchers + m)) {
+					break; /* not found */
+				}
+			}
+			if (m == nmatchers + nxmatchers) {
+				break; /* mapping node found */
+			}
+			mnode = mnode->next;
+		}
+	} else {
+		/* Adds name and nparams to the first free function: */
+		if (nf == moc_ctx.maxfuncs) {
+			moc_send_error(MOC_ERR_NFUNLIMIT, funcname, 0,
+					0, 0);
+			return MOC_NULLNODE;
+		}
+		func = moc_ctx.funcs + nf;
+		func->name = funcname;
+		func->nparams = nmatchers;
+		func->compiled = 0;
+		func->ptypes = 0;
+		func->self = moc_ctx.self;
+		moc_inilist(&(func->lmaps));
+		mnode = MOC_NULLNODE;
+		nfuncsinc++; /* to remember increasing it */
 	}
 	/* Checks if there is enough memory to add the mapping: */
 	if (mnode == MOC_NULLNODE && moc_ctx.nmaps == moc_ctx.maxmaps) {
 		moc_send_error(MOC_ERR_NMAPLIMIT, funcname, 0, 0, 0);
-		return;
+		return MOC_NULLNODE;
 	}
 	if (mnode == MOC_NULLNODE && moc_ctx.maxmatcs - moc_ctx.nmatcs
 			< nmatchers + nxmatchers) {
 		moc_send_error(MOC_ERR_NMTCLIMIT, funcname, 0, 0, 0);
-		return;
+		return MOC_NULLNODE;
+	}
+	/* The struct values are copied to the memory of the nodes: */
+	for (m = 0; mnode == MOC_NULLNODE && m < nmatchers; m++) {
+		nstnodes += moc_stnodes(MOC_IMTC(matchers + m)->mval);
+	}
+	for (m = 0; mnode == MOC_NULLNODE && m < nxmatchers; m++) {
+		nstnodes += moc_stnodes(MOC_IMTC(xmatchers + m)->mval);
+	}
+	for (r = 0; r < nresponders; r++) {
+		nstnodes += moc_stnodes(MOC_IRSP(responders + r)->rval);
 	}
-	if (moc_ctx.maxlnods - moc_ctx.nlnods
-			< (mnode == MOC_NULLNODE ? 1 : 0) + 1) {
+	if ((unsigned long) (moc_ctx.maxlnods - moc_ctx.nlnods)
+			< (mnode == MOC_NULLNODE ? 1 : 0) + 1 + nstnodes) {
 		moc_send_error(MOC_ERR_NNODLIMIT, funcname, 0, 0, 0);
-		return;
+		return MOC_NULLNODE;
 	}
 	if (moc_ctx.maxresps - moc_ctx.nresps < nresponders) {
 		moc_send_error(MOC_ERR_NRSPLIMIT, funcname, 0, 0, 0);
-		return;
+		return MOC_NULLNODE;
 	}
 	pos = 1;
 	for (m = 0; m < nmatchers; m++, pos++) {
@@ -2230,7 +3257,7 @@ static void moc_given_nnn(const char *funcname, MOC_NUM_T nmatchers,
 		if (! moc_isvalidtype(type)) {
 			moc_send_error(MOC_ERR_INVALTYPE, funcname, pos,
 					type, type);
-			return;
+			return MOC_NULLNODE;
 		}
 	}
 	for (m = 0; m < nxmatchers; m++, pos++) {
@@ -2238,7 +3265,7 @@ static void moc_given_nnn(const char *funcname, MOC_NUM_T nmatchers,
 		if (! moc_isvalidtype(type)) {
 			moc_send_error(MOC_ERR_INVALTYPE, funcname, pos,
 					type, type);
-			return;
+			return MOC_NULLNODE;
 		}
 	}
 	for (r = 0; r < nresponders; r++, pos++) {
@@ -2246,9 +3273,14 @@ static void moc_given_nnn(const char *funcname, MOC_NUM_T nmatchers,
 		if (! moc_isvalidtype(type)) {
 			moc_send_error(MOC_ERR_INVALTYPE, funcname, pos,
 					type, type);
-			return;
+			return MOC_NULLNODE;
 		}
 	}
+	/* The mappings of declared functions are checked only once: */
+	if (func->ptypes != 0 && ! moc_chkdecl(func, matchers,
+			nxmatchers, xmatchers, nresponders, responders)) {
+		return MOC_NULLNODE;
+	}
 	moc_ctx.nfuncs += nfuncsinc;
 	if (mnode == MOC_NULLNODE) {
 		/* Adds matchers to a new mapping inserted the last: */
@@ -2258,6 +3290,7 @@ static void moc_given_nnn(const char *funcname, MOC_NUM_T nmatchers,
 		moc_ctx.nlnods++;
 		moc_inilistnode(mnode, map, 1);
 		moc_inslastlistnode(&(func->lmaps), mnode);
+		func->compiled = 0; /* the new mapping is not compiled */
 		map->matchers = moc_ctx.matcs + moc_ctx.nmatcs;
 		map->nxmatchers = nxmatchers;
 		moc_ctx.nmatcs += nmatchers + nxmatchers;
@@ -2267,7 +3300,12 @@ static void moc_given_nnn(const char *funcname, MOC_NUM_T nmatchers,
 		for (m = 0; m < nxmatchers; m++) {
 			map->matchers[m + nmatchers] = xmatchers[m];
 		}
+		for (m = 0; m < nmatchers + nxmatchers; m++) {
+			moc_stcopy(&MOC_IMTC(map->matchers + m)->mval);
+		}
+		moc_packsig(map, nmatchers);
 		moc_inilist(&(map->lresps));
+		map->rfirst = MOC_NULLNODE;
 	} else {
 		map = (struct moc_mapping *) mnode->item;
 	}
@@ -2278,17 +3316,16 @@ static void moc_given_nnn(const char *funcname, MOC_NUM_T nmatchers,
 	moc_ctx.nlnods++;
 	moc_inilistnode(rnode, resps, nresponders);
 	moc_inslastlistnode(&(map->lresps), rnode);
+	if (map->rfirst == MOC_NULLNODE) {
+		map->rfirst = rnode;
+	}
 	for (r = 0; r < nresponders; r++) {
 		resps[r] = responders[r];
+		moc_stcopy(&MOC_IRSP(resps + r)->rval);
 	}
-}
-
-static moc_bool moc_iscmpfn(struct moc_matcher *mtc) {
-	moc_mtcfn_param_t fn;
-	fn = MOC_IMTC(mtc)->mtcfn.prm;
-	return (fn == moc_cmplt || fn == moc_cmple
-		|| fn == moc_cmpgt || (fn == moc_cmpge
-			? moc_true : moc_false));
+	moc_fpgiven(funcname, nmatchers, matchers, nxmatchers, xmatchers,
+			nresponders, responders, seqnode != MOC_NULLNODE);
+	return mnode;
 }
 
 static moc_bool moc_chkmtc(struct moc_matcher *pm, int pos,
@@ -2296,37 +3333,25 @@ static moc_bool moc_chkmtc(struct moc_matcher *pm, int pos,
 		struct moc_value *params) {
 	MOC_OPTS_T opts;
 	moc_type type;
+	unsigned char errnum;
 	opts = MOC_IMTC(pm)->mopts;
-	if ((pos <= nparams && opts != 0 && opts != 128)
-	|| (pos > nparams && (opts == 0 || opts == 128))) {
-		moc_send_error(MOC_ERR_INVALMTCH, funcname, pos, 0, 0);
-		return moc_false;
-	}
-	if (pos > nparams && (opts == MOC_MAXPARAMS
-			|| (opts < MOC_MAXPARAMS && opts > nparams)
-			|| (opts > 128 && opts < 128 + MOC_MAXPARAMS
-					&& opts - 128 > nparams))) {
-		moc_send_error(MOC_ERR_INVNPARAM, funcname, pos, 0, 0);
-		return moc_false;
-	}
 	type = MOC_VALBYTE(MOC_IMTC(pm)->mval);
-	if (! moc_isvalidtype(type)) {
-		moc_send_error(MOC_ERR_INVALTYPE, funcname, pos,
-				type, type);
+	errnum = moc_chkmtcpos(pm, pos, nparams);
+	if (errnum == MOC_ERR_INVALTYPE) {
+		moc_send_error(errnum, funcname, pos, type, type);
 		return moc_false;
 	}
-	if (type == MOC_TYPES2BYTE(MOC_FUN, MOC_NOPTR)
-			&& moc_iscmpfn(pm)) {
-		moc_send_error(MOC_ERR_INVALOPER, funcname, pos, 0, 0);
+	if (errnum != 0) {
+		moc_send_error(errnum, funcname, pos, 0, 0);
 		return moc_false;
 	}
-	if (pos <= nparams && opts < MOC_MAXPARAMS
+	if (pos <= nparams && opts < MOC_NOPARAM
 			&& type != MOC_VALBYTE(params[pos - 1])) {
 		moc_send_error(MOC_ERR_PARAMTYPE, funcname, pos,
 				MOC_VALBYTE(params[pos - 1]), type);
 		return moc_false;
 	}
-	if (pos > nparams && opts < MOC_MAXPARAMS
+	if (pos > nparams && opts < MOC_NOPARAM
 			&& type != MOC_VALBYTE(params[opts - 1])) {
 		moc_send_error(MOC_ERR_PARAMTYPE, funcname, pos,
 				MOC_VALBYTE(params[opts - 1]), type);
@@ -2335,26 +3360,89 @@ static moc_bool moc_chkmtc(struct moc_matcher *pm, int pos,
 	return moc_true;
 }
 
+/* Compiled operations of the ordinary matchers of compiled functions,
+ * the comparisons are MOC_FOP_CMP plus the comparison operator. */
+#define MOC_FOP_NONE 0 /* not compiled, its function must be called */
+#define MOC_FOP_ANY  1 /* matches any value of any type */
+#define MOC_FOP_TYPE 2 /* matches any value of the type */
+#define MOC_FOP_CMP  3 /* compares the value with the given operator */
+
+/* Returns the compiled operation of a valid ordinary matcher. */
+static MOC_OPTS_T moc_fastop(struct moc_matcher *pm) {
+	moc_mtcfn_param_t fn;
+	fn = MOC_IMTC(pm)->mtcfn.prm;
+	if (MOC_IMTC(pm)->mopts != 0) {
+		return fn == moc_mtctrue ? MOC_FOP_ANY : MOC_FOP_NONE;
+	}
+	if (fn == moc_mtctrue) return MOC_FOP_TYPE;
+	if (fn == moc_cmpeq) return MOC_FOP_CMP + MOC_EQ;
+	if (fn == moc_cmpne) return MOC_FOP_CMP + MOC_NE;
+	if (fn == moc_cmplt) return MOC_FOP_CMP + MOC_LT;
+	if (fn == moc_cmple) return MOC_FOP_CMP + MOC_LE;
+	if (fn == moc_cmpgt) return MOC_FOP_CMP + MOC_GT;
+	if (fn == moc_cmpge) return MOC_FOP_CMP + MOC_GE;
+	return MOC_FOP_NONE;
+}
+
+void moc_compile(const char *funcname) {
+	struct moc_function *func;
+	struct moc_listnode *mnode;
+	struct moc_mapping *map;
+	MOC_SIZE_T f, m;
+	for (f = 0; f < moc_ctx.nfuncs; f++) {
+		func = moc_ctx.funcs + f;
+		if (moc_strcmp(func->name, funcname) != 0) {
+			continue;
+		}
+		/* Validates all the matchers before compiling them: */
+		for (mnode = func->lmaps.first; mnode != MOC_NULLNODE;
+				mnode = mnode->next) {
+			map = (struct moc_mapping *) mnode->item;
+			for (m = 0; m < func->nparams + map->nxmatchers; m++) {
+				if (moc_chkmtcpos(map->matchers + m, m + 1,
+						func->nparams) != 0) {
+					break;
+				}
+			}
+			if (m < func->nparams + map->nxmatchers) {
+				break; /* errors will be reported on calls */
+			}
+		}
+		if (mnode != MOC_NULLNODE) {
+			continue;
+		}
+		for (mnode = func->lmaps.first; mnode != MOC_NULLNODE;
+				mnode = mnode->next) {
+			map = (struct moc_mapping *) mnode->item;
+			for (m = 0; m < func->nparams + map->nxmatchers; m++) {
+				MOC_IMTC(map->matchers + m)->mfop =
+					(MOC_OPTS_T) (m < func->nparams
+					? moc_fastop(map->matchers + m)
+					: MOC_FOP_NONE);
+			}
+		}
+		func->compiled = 1;
+	}
+}
+
 static moc_bool moc_chkrsp(struct moc_responder *pr, int pos,
 		const char *funcname, unsigned char nparams,
 		struct moc_value *params) {
 	MOC_OPTS_T opts;
 	moc_type type;
+	unsigned char errnum;
 	opts = MOC_IRSP(pr)->ropts;
-	if (opts == 0 || opts == MOC_MAXPARAMS
-			|| (opts < MOC_MAXPARAMS && opts > nparams)
-			|| (opts > 128 && opts < 128 + MOC_MAXPARAMS
-					&& opts - 128 > nparams)) {
-		moc_send_error(MOC_ERR_INVNPARAM, funcname, pos, 0, 0);
+	type = MOC_VALBYTE(MOC_IRSP(pr)->rval);
+	errnum = moc_chkrsppos(pr, nparams);
+	if (errnum == MOC_ERR_INVALTYPE) {
+		moc_send_error(errnum, funcname, pos, type, type);
 		return moc_false;
 	}
-	type = MOC_VALBYTE(MOC_IRSP(pr)->rval);
-	if (! moc_isvalidtype(type)) {
-		moc_send_error(MOC_ERR_INVALTYPE, funcname, pos,
-				type, type);
+	if (errnum != 0) {
+		moc_send_error(errnum, funcname, pos, 0, 0);
 		return moc_false;
 	}
-	if (opts < MOC_MAXPARAMS
+	if (opts < MOC_NOPARAM
 			&& type != MOC_VALBYTE(params[opts - 1])) {
 		moc_send_error(MOC_ERR_PARAMTYPE, funcname, pos,
 				MOC_VALBYTE(params[opts - 1]), type);
@@ -2363,89 +3451,507 @@ static moc_bool moc_chkrsp(struct moc_responder *pr, int pos,
 	return moc_true;
 }
 
-static struct moc_value moc_act_n(const char *funcname, moc_type rettype,
-		unsigned char nparams, struct moc_value *params) {
-	struct moc_listnode *mnode, *rnode;
-	struct moc_matcher *pm;
-	struct moc_responder *pr, *responders;
-	struct moc_mapping *map;
-	struct moc_value retval;
-	struct moc_call call;
-	MOC_SIZE_T nf, f, m, r;
-	MOC_OPTS_T opts;
-	int i;
-	/* Searches the function by name and nparams: */
-	nf = moc_ctx.nfuncs;
-	for (f = 0; f < nf; f++) {
-		if (moc_ctx.funcs[f].nparams == nparams
-				&& moc_strcmp(moc_ctx.funcs[f].name,
-					funcname) == 0) {
-			break;
+/* Returns the value stored in a cell of a static table row. */
+static struct moc_value moc_tblval(const struct moc_tblcell *cell) {
+	struct moc_value value;
+	MOC_EMPTYVAL(value);
+	if (MOC_PTRTYPE(cell->type) != MOC_NOPTR) {
+		*((const void **) MOC_VALDATA(value)) = cell->pval;
+	} else {
+		switch (MOC_STDTYPE(cell->type)) {
+			case MOC_CHR: MOC_GET_C(value) =
+					(char) cell->ival; break;
+			case MOC_SHR: MOC_GET_S(value) =
+					(short) cell->ival; break;
+			case MOC_INT: MOC_GET_I(value) =
+					(int) cell->ival; break;
+			case MOC_LNG: MOC_GET_L(value) = cell->ival; break;
+			case MOC_FLT: MOC_GET_F(value) =
+					(float) cell->dval; break;
+			case MOC_DBL: MOC_GET_D(value) = cell->dval; break;
+			case MOC_SCHR: MOC_GET_SC(value) =
+					(signed char) cell->ival; break;
+			case MOC_UCHR: MOC_GET_UC(value) =
+					(unsigned char) cell->ival; break;
+			case MOC_USHR: MOC_GET_US(value) =
+					(unsigned short) cell->ival; break;
+			case MOC_UINT: MOC_GET_UI(value) =
+					(unsigned int) cell->ival; break;
+			case MOC_ULNG: MOC_GET_UL(value) =
+					(unsigned long) cell->ival; break;
+			default: break;
 		}
 	}
-	if (f == nf) {
-		moc_send_error(MOC_ERR_FUNNOTFND, funcname, nparams,
-				0, 0);
-		return moc_emptyval;
+	MOC_VALBYTE(value) = cell->type;
+	return value;
+}
+
+void moc_attach_table(const struct moc_tblrow *rows, unsigned int nrows) {
+	moc_ctx.tblrows = rows;
+	moc_ctx.ntblrows = nrows;
+	moc_ctx.tblstamp++;
+}
+
+/* Returns 1 if the parameter matches the cell of a static table, 0 if
+ * it does not match, or -1 after reporting an error. */
+static int moc_tblmatch(const struct moc_tblcell *cell,
+		const char *funcname, MOC_SIZE_T pos, struct moc_value param) {
+	if (cell->kind == MOC_TBLKIND_ANY) {
+		return 1;
 	}
-	/* Searches a mapping node that matches all the matchers: */
-	mnode = moc_ctx.funcs[f].lmaps.first;
-	while (mnode != MOC_NULLNODE) {
-		map = (struct moc_mapping *) mnode->item;
-		for (m = 0; m < nparams + map->nxmatchers; m++) {
-			pm = map->matchers + m;
-			if (! moc_chkmtc(pm, m + 1, funcname,
-					nparams, params)) {
+	if (! moc_isvalidtype(cell->type) || (cell->kind != MOC_TBLKIND_EQ
+				&& cell->kind != MOC_TBLKIND_STR)) {
+		moc_send_error(MOC_ERR_INVALTYPE, funcname, pos,
+				cell->type, cell->type);
+		return -1;
+	}
+	if (cell->type != MOC_VALBYTE(param)) {
+		moc_send_error(MOC_ERR_PARAMTYPE, funcname, pos,
+				MOC_VALBYTE(param), cell->type);
+		return -1;
+	}
+	if (cell->kind == MOC_TBLKIND_STR
+			? ! moc_cmpeqstr(param, moc_tblval(cell))
+			: ! moc_values_eq(param, moc_tblval(cell))) {
+		return 0;
+	}
+	return 1;
+}
+
+/* Searches the attached static table for a row matching the call,
+ * sending the given error if the function has no matching row. */
+static struct moc_value moc_act_tbl(const char *funcname,
+		moc_type rettype, unsigned char nparams,
+		struct moc_value *params, unsigned char errnum) {
+	const struct moc_tblrow *row;
+	struct moc_value retval;
+	unsigned int t;
+	MOC_NUM_T m;
+	int match;
+	moc_ctx.nextcaller = -1; /* not used by the tables */
+	for (t = 0; t < moc_ctx.ntblrows; t++) {
+		row = moc_ctx.tblrows + t;
+		if (row->nparams != nparams
+				|| moc_strcmp(row->funcname, funcname) != 0) {
+			continue;
+		}
+		for (m = 0; m < nparams; m++) {
+			match = moc_tblmatch(row->params + m, funcname,
+					m + 1, params[m]);
+			if (match < 0) {
 				return moc_emptyval;
 			}
-			opts = MOC_IMTC(pm)->mopts;
-			if (opts == 128 + MOC_MAXPARAMS) {
-				call.funcname = funcname;
-				call.nparams = nparams;
-				call.params = params;
-				if (! MOC_IMTC(pm)->mtcfn.cll(&call,
-						MOC_IMTC(pm)->mval)) {
-					break; /* matchers don't match */
-				}
-			} else {
-				if (m < nparams) {
-					i = m;
-				} else {
-					i = opts > 128 ? opts - 128 - 1
-						: opts - 1;
-				}
-				if (! MOC_IMTC(pm)->mtcfn.prm(params[i],
-						MOC_IMTC(pm)->mval)) {
-					break; /* matchers don't match */
-				}
+			if (match == 0) {
+				break; /* cells don't match */
 			}
 		}
-		if (m == nparams + map->nxmatchers) {
-			break; /* matchers matched */
+		if (m == nparams) {
+			retval = moc_tblval(&(row->ret));
+			if (MOC_VALBYTE(retval) != rettype) {
+				moc_send_error(MOC_ERR_RETURTYPE, funcname, 0,
+						MOC_VALBYTE(retval), rettype);
+			}
+			return retval;
 		}
-		mnode = mnode->next;
 	}
-	if (mnode == MOC_NULLNODE) {
-		moc_send_error(MOC_ERR_MAPNOTFND, funcname, nparams,
-				0, 0);
-		return moc_emptyval;
+	moc_send_error(errnum, funcname, nparams, 0, 0);
+	return moc_emptyval;
+}
+
+moc_bool moc_init_fsm(struct moc_fsm *fsm,
+		const struct moc_transition *transitions,
+		unsigned int ntransitions, int state) {
+	const struct moc_transition *tr;
+	unsigned int t;
+	int s;
+	for (t = 0; t < ntransitions; t++) {
+		tr = transitions + t;
+		if (tr->state < 0 || tr->state >= MOC_FSMSTATES
+				|| tr->next < 0 || tr->next >= MOC_FSMSTATES
+				|| (t > 0 && tr->state < tr[-1].state)
+				|| tr->ret.kind != MOC_TBLKIND_RET
+				|| ! moc_isvalidtype(tr->ret.type)) {
+			moc_send_error(MOC_ERR_INVALTRAN, tr->funcname,
+					t + 1, 0, 0);
+			return moc_false;
+		}
 	}
-	/* Checks the data of the responders before executing them: */
-	rnode = map->lresps.first;
-	responders = (struct moc_responder *) rnode->item;
-	for (r = 0; r < rnode->nitems; r++) {
-		if (! moc_chkrsp(responders + r, 1 + r + m, funcname,
-					nparams, params)) {
+	if (state < 0 || state >= MOC_FSMSTATES) {
+		moc_send_error(MOC_ERR_INVALTRAN, "initial state", 0, 0, 0);
+		return moc_false;
+	}
+	/* Indexes the first transition of each state: */
+	fsm->transitions = transitions;
+	for (s = 0, t = 0; s <= MOC_FSMSTATES; s++) {
+		while (t < ntransitions && transitions[t].state < s) {
+			t++;
+		}
+		fsm->first[s] = t;
+	}
+	fsm->state = state;
+	return moc_true;
+}
+
+int moc_fsm_state(const struct moc_fsm *fsm) {
+	return fsm->state;
+}
+
+static struct moc_value moc_rspfsm(struct moc_call *call,
+		struct moc_value val) {
+	struct moc_fsm *fsm;
+	const struct moc_transition *tr;
+	unsigned int t;
+	int match;
+	fsm = (struct moc_fsm *) MOC_GET_P(val);
+	/* Checks only the transitions of the current state: */
+	for (t = fsm->first[fsm->state]; t < fsm->first[fsm->state + 1];
+			t++) {
+		tr = fsm->transitions + t;
+		if (moc_strcmp(tr->funcname, call->funcname) != 0) {
+			continue;
+		}
+		match = call->nparams == 0 ? 1 : moc_tblmatch(&(tr->param),
+				call->funcname, 1, call->params[0]);
+		if (match < 0) {
 			return moc_emptyval;
 		}
+		if (match > 0) {
+			fsm->state = tr->next;
+			return moc_tblval(&(tr->ret));
+		}
+	}
+	moc_send_error(MOC_ERR_INVALTRAN, call->funcname,
+			(MOC_SIZE_T) fsm->state, 0, 0);
+	return moc_emptyval;
+}
 
+struct moc_responder moc_transit(struct moc_fsm *fsm) {
+	return moc_rcall(&moc_rspfsm, moc_p(fsm));
+}
+
+/* Converts an integer or pointer value to unsigned long, returning
+ * moc_false if the value has another type. */
+static moc_bool moc_valul(struct moc_value value, unsigned long *ul) {
+	if (MOC_VALPTRTYPE(value) != MOC_NOPTR) {
+		*ul = (unsigned long) MOC_GET_P(value);
+		return moc_true;
 	}
-	/* Executes the first responders of the mapping: */
-	retval = moc_emptyval; /* default value */
+	switch (MOC_VALSTDTYPE(value)) {
+		case MOC_CHR: *ul = (unsigned long) MOC_GET_C(value); break;
+		case MOC_SHR: *ul = (unsigned long) MOC_GET_S(value); break;
+		case MOC_INT: *ul = (unsigned long) MOC_GET_I(value); break;
+		case MOC_LNG: *ul = (unsigned long) MOC_GET_L(value); break;
+		case MOC_SCHR: *ul = (unsigned long) MOC_GET_SC(value); break;
+		case MOC_UCHR: *ul = MOC_GET_UC(value); break;
+		case MOC_USHR: *ul = MOC_GET_US(value); break;
+		case MOC_UINT: *ul = MOC_GET_UI(value); break;
+		case MOC_ULNG: *ul = MOC_GET_UL(value); break;
+		default: return moc_false;
+	}
+	return moc_true;
+}
+
+/* Returns the unsigned long converted to a value of the integer type. */
+static struct moc_value moc_ulval(unsigned long ul, moc_type type) {
+	struct moc_value value;
+	MOC_EMPTYVAL(value);
+	switch (MOC_STDTYPE(type)) {
+		case MOC_CHR: MOC_GET_C(value) = (char) ul; break;
+		case MOC_SHR: MOC_GET_S(value) = (short) ul; break;
+		case MOC_INT: MOC_GET_I(value) = (int) ul; break;
+		case MOC_LNG: MOC_GET_L(value) = (long) ul; break;
+		case MOC_SCHR: MOC_GET_SC(value) = (signed char) ul; break;
+		case MOC_UCHR: MOC_GET_UC(value) = (unsigned char) ul; break;
+		case MOC_USHR: MOC_GET_US(value) = (unsigned short) ul; break;
+		case MOC_UINT: MOC_GET_UI(value) = (unsigned int) ul; break;
+		case MOC_ULNG: MOC_GET_UL(value) = ul; break;
+		default: break;
+	}
+	MOC_VALBYTE(value) = type;
+	return value;
+}
+
+moc_bool moc_init_regfile(struct moc_regfile *file,
+		struct moc_register *regs, unsigned int nregs,
+		moc_type type) {
+	unsigned int r;
+	if (MOC_PTRTYPE(type) != MOC_NOPTR || MOC_STDTYPE(type) == MOC_VOID
+			|| MOC_STDTYPE(type) == MOC_FLT
+			|| MOC_STDTYPE(type) == MOC_DBL
+			|| MOC_STDTYPE(type) >= MOC_FUN) {
+		moc_send_error(MOC_ERR_INVALTYPE, "register file", 0,
+				type, type);
+		return moc_false;
+	}
+	for (r = 1; r < nregs; r++) {
+		if (regs[r].addr <= regs[r - 1].addr) {
+			moc_send_error(MOC_ERR_INVALADDR, "register file",
+					r + 1, 0, 0);
+			return moc_false;
+		}
+	}
+	file->regs = regs;
+	file->nregs = nregs;
+	file->type = type;
+	/* The registers at regular distances are found by their index: */
+	file->stride = nregs > 1 ? regs[1].addr - regs[0].addr : 1;
+	for (r = 2; r < nregs && file->stride != 0; r++) {
+		if (regs[r].addr - regs[r - 1].addr != file->stride) {
+			file->stride = 0;
+		}
+	}
+	return moc_true;
+}
+
+struct moc_register *moc_find_register(struct moc_regfile *file,
+		unsigned long addr) {
+	unsigned int lo, hi, mid;
+	unsigned long i;
+	if (file->nregs == 0 || addr < file->regs[0].addr) {
+		return 0;
+	}
+	if (file->stride != 0) {
+		i = (addr - file->regs[0].addr) / file->stride;
+		return i < file->nregs && file->regs[i].addr == addr
+			? file->regs + i : 0;
+	}
+	lo = 0;
+	hi = file->nregs;
+	while (lo < hi) {
+		mid = lo + (hi - lo) / 2;
+		if (file->regs[mid].addr == addr) {
+			return file->regs + mid;
+		}
+		if (file->regs[mid].addr < addr) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+	return 0;
+}
+
+/* Returns the register of the address in the first parameter of the
+ * call, or 0 after reporting an error. */
+static struct moc_register *moc_callreg(struct moc_regfile *file,
+		struct moc_call *call) {
+	struct moc_register *reg;
+	unsigned long addr;
+	if (call->nparams == 0 || ! moc_valul(call->params[0], &addr)) {
+		moc_send_error(MOC_ERR_INVALADDR, call->funcname, 1, 0, 0);
+		return 0;
+	}
+	reg = moc_find_register(file, addr);
+	if (reg == 0) {
+		moc_send_error(MOC_ERR_INVALADDR, call->funcname, 1, 0, 0);
+	}
+	return reg;
+}
+
+static struct moc_value moc_rspregrd(struct moc_call *call,
+		struct moc_value val) {
+	struct moc_regfile *file;
+	struct moc_register *reg;
+	unsigned long ul;
+	file = (struct moc_regfile *) MOC_GET_P(val);
+	reg = moc_callreg(file, call);
+	if (reg == 0) {
+		return moc_emptyval;
+	}
+	reg->nreads++;
+	if (reg->onread != 0) {
+		reg->onread(file, reg, reg->value);
+	}
+	ul = reg->value;
+	reg->value &= ~reg->rclear; /* bits cleared when read */
+	return moc_ulval(ul, file->type);
+}
+
+static struct moc_value moc_rspregwr(struct moc_call *call,
+		struct moc_value val) {
+	struct moc_regfile *file;
+	struct moc_register *reg;
+	unsigned long ul;
+	file = (struct moc_regfile *) MOC_GET_P(val);
+	reg = moc_callreg(file, call);
+	if (reg == 0) {
+		return moc_emptyval;
+	}
+	if (call->nparams < 2 || ! moc_valul(call->params[1], &ul)) {
+		moc_send_error(MOC_ERR_PARAMTYPE, call->funcname, 2,
+				call->nparams < 2 ? 0
+				: MOC_VALBYTE(call->params[1]), file->type);
+		return moc_emptyval;
+	}
+	reg->nwrites++;
+	/* The bits written with 1 are cleared in the w1clear mask: */
+	reg->value = (ul & ~reg->w1clear)
+		| (reg->value & reg->w1clear & ~ul);
+	if (reg->onwrite != 0) {
+		reg->onwrite(file, reg, ul);
+	}
+	return moc_emptyval;
+}
+
+struct moc_responder moc_read_register(struct moc_regfile *file) {
+	return moc_rcall(&moc_rspregrd, moc_p(file));
+}
+
+struct moc_responder moc_write_register(struct moc_regfile *file) {
+	return moc_rcall(&moc_rspregwr, moc_p(file));
+}
+
+/* Returns the position of the function with the name and nparams
+ * or the number of functions if it is not found. */
+static MOC_SIZE_T moc_findfunc(const char *funcname, unsigned char nparams) {
+	MOC_SIZE_T nf, f;
+	nf = moc_ctx.nfuncs;
+	for (f = 0; f < nf; f++) {
+		if (moc_ctx.funcs[f].nparams == nparams
+				&& moc_ctx.funcs[f].self == 0
+				&& moc_strcmp(moc_ctx.funcs[f].name,
+					funcname) == 0) {
+			break;
+		}
+	}
+	return f;
+}
+
+/* Executes the mappings of the function found in the given position. */
+static struct moc_value moc_dispatch(MOC_SIZE_T f, const char *funcname,
+		moc_type rettype, unsigned char nparams,
+		struct moc_value *params) {
+	struct moc_listnode *mnode, *rnode;
+	struct moc_matcher *pm;
+	struct moc_responder *pr, *responders;
+	struct moc_mapping *map;
+	struct moc_value retval;
+	struct moc_call call;
+	MOC_SIZE_T m, r;
+	MOC_OPTS_T opts, fop;
+	MOC_NUM_T compiled, checked = 0, fast;
+	const moc_type *ptypes;
+	unsigned long sig = 0;
+	int i;
+	unsigned long start = 0;
+	if (moc_ctx.clockfn != 0) {
+		/* Includes the time of finding the function: */
+		start = moc_ctx.started ? moc_ctx.callstart
+			: moc_ctx.clockfn();
+		moc_ctx.started = moc_false;
+		moc_ctx.curspy = 0;
+	}
+	/* The mappings of declared functions were checked when added,
+	 * so only the types of the call are checked with the signature,
+	 * and nothing is checked when the calls are trusted: */
+	ptypes = moc_ctx.funcs[f].ptypes;
+	if (ptypes != 0 && moc_ctx.trusted) {
+		checked = 1;
+	} else if (ptypes != 0) {
+		for (i = 0; i < nparams; i++) {
+			if (ptypes[i] != MOC_VALBYTE(params[i])) {
+				moc_send_error(MOC_ERR_PARAMTYPE, funcname,
+					i + 1, MOC_VALBYTE(params[i]),
+					ptypes[i]);
+				return moc_emptyval;
+			}
+		}
+		if (rettype != moc_ctx.funcs[f].rettype) {
+			moc_send_error(MOC_ERR_RETURTYPE, funcname, 0,
+					rettype, moc_ctx.funcs[f].rettype);
+			return moc_emptyval;
+		}
+		checked = 1;
+	} else {
+		/* Packs the types of the first parameters in a word: */
+		for (i = 0; i < nparams && i < (int) MOC_SIGLEN; i++) {
+			sig |= (unsigned long) MOC_VALBYTE(params[i])
+				<< (8 * i);
+		}
+	}
+	/* Searches a mapping node that matches all the matchers: */
+	compiled = moc_ctx.funcs[f].compiled;
+	mnode = moc_ctx.funcs[f].lmaps.first;
+	while (mnode != MOC_NULLNODE) {
+		map = (struct moc_mapping *) mnode->item;
+		/* The matchers are checked one by one only if the types
+		 * do not match at once, for finding the wrong one: */
+		fast = checked || (map->packed
+				&& (sig & map->sigmask) == map->sigtypes);
+		for (m = 0; m < nparams + map->nxmatchers; m++) {
+			pm = map->matchers + m;
+			fop = compiled ? MOC_IMTC(pm)->mfop : MOC_FOP_NONE;
+			if (fop != MOC_FOP_NONE) {
+				/* Compiled matchers are already validated: */
+				if (fop == MOC_FOP_ANY) {
+					continue;
+				}
+				if (! fast && MOC_VALBYTE(MOC_IMTC(pm)->mval)
+						!= MOC_VALBYTE(params[m])) {
+					moc_send_error(MOC_ERR_PARAMTYPE,
+						funcname, m + 1,
+						MOC_VALBYTE(params[m]),
+						MOC_VALBYTE(MOC_IMTC(pm)->mval));
+					return moc_emptyval;
+				}
+				if (fop != MOC_FOP_TYPE && ! moc_cmpop(params[m],
+						MOC_IMTC(pm)->mval, (enum moc_op)
+							(fop - MOC_FOP_CMP))) {
+					break; /* matchers don't match */
+				}
+				continue;
+			}
+			if (! fast && ! moc_chkmtc(pm, m + 1, funcname,
+					nparams, params)) {
+				return moc_emptyval;
+			}
+			opts = MOC_IMTC(pm)->mopts;
+			if (opts == 128 + MOC_NOPARAM) {
+				call.funcname = funcname;
+				call.nparams = nparams;
+				call.params = params;
+				if (! MOC_IMTC(pm)->mtcfn.cll(&call,
+						MOC_IMTC(pm)->mval)) {
+					break; /* matchers don't match */
+				}
+			} else {
+				if (m < nparams) {
+					i = m;
+				} else {
+					i = opts > 128 ? opts - 128 - 1
+						: opts - 1;
+				}
+				if (! MOC_IMTC(pm)->mtcfn.prm(params[i],
+						MOC_IMTC(pm)->mval)) {
+					break; /* matchers don't match */
+				}
+			}
+		}
+		if (m == nparams + map->nxmatchers) {
+			break; /* matchers matched */
+		}
+		mnode = mnode->next;
+	}
+	if (mnode == MOC_NULLNODE) {
+		return moc_act_tbl(funcname, rettype, nparams, params,
+				MOC_ERR_MAPNOTFND);
+	}
+	/* Checks the data of the responders before executing them: */
+	rnode = map->lresps.first;
+	responders = (struct moc_responder *) rnode->item;
+	for (r = 0; ! checked && r < rnode->nitems; r++) {
+		if (! moc_chkrsp(responders + r, 1 + r + m, funcname,
+					nparams, params)) {
+			return moc_emptyval;
+		}
+
+	}
+	/* Executes the first responders of the mapping: */
+	retval = moc_emptyval; /* default value */
 	for (r = 0; r < rnode->nitems; r++) {
 		pr = responders + r;
 		opts = MOC_IRSP(pr)->ropts;
-		if (opts == 128 + MOC_MAXPARAMS) {
+		if (opts == 128 + MOC_NOPARAM) {
 			call.funcname = funcname;
 			call.nparams = nparams;
 			call.params = params;
@@ -2457,7 +3963,8 @@ static struct moc_value moc_act_n(const char *funcname, moc_type rettype,
 						MOC_IRSP(pr)->rval);
 		}
 	}
-	if (MOC_VALBYTE(retval) != rettype) {
+	if (MOC_VALBYTE(retval) != rettype
+			&& ! (checked && moc_ctx.trusted)) {
 		moc_send_error(MOC_ERR_RETURTYPE, funcname, 0,
 				MOC_VALBYTE(retval), rettype);
 	}
@@ -2466,13 +3973,18 @@ static struct moc_value moc_act_n(const char *funcname, moc_type rettype,
 		moc_inslastlistnode(&(map->lresps),
 				moc_delfirstlistnode(&(map->lresps)));
 	}
+	if (moc_ctx.clockfn != 0 && moc_ctx.curspy != 0) {
+		moc_ctx.curspy->moctime += moc_ctx.clockfn() - start
+			- moc_ctx.spytime;
+		moc_ctx.curspy = 0;
+	}
 	return retval;
 }
 
 void moc_given(const char *funcname, struct moc_matchers_grp mgrp,
 		struct moc_responders_grp rgrp) {
 	moc_given_nnn(funcname, mgrp.nelems, mgrp.elems, 0, mgrp.elems,
-			rgrp.nelems, rgrp.elems);
+			rgrp.nelems, rgrp.elems, MOC_NULLNODE);
 }
 
 void moc_given_extra(const char *funcname, struct moc_matchers_grp mgrp,
@@ -2480,11 +3992,1860 @@ void moc_given_extra(const char *funcname, struct moc_matchers_grp mgrp,
 		struct moc_responders_grp rgrp) {
 	moc_given_nnn(funcname, mgrp.nelems, mgrp.elems,
 			mxgrp.nelems, mxgrp.elems,
-			rgrp.nelems, rgrp.elems);
+			rgrp.nelems, rgrp.elems, MOC_NULLNODE);
+}
+
+void moc_given_v(const char *funcname, unsigned char nmatchers,
+		struct moc_matcher *matchers, unsigned char nresponders,
+		struct moc_responder *responders) {
+	if (nmatchers > MOC_MAXPARAMS) {
+		moc_send_error(MOC_ERR_INVNPARAM, funcname, nmatchers, 0, 0);
+		return;
+	}
+	moc_given_nnn(funcname, nmatchers, matchers, 0, matchers,
+			nresponders, responders, MOC_NULLNODE);
+}
+
+moc_bool moc_declare(const char *funcname, moc_type rettype,
+		unsigned char nparams, const moc_type *paramtypes) {
+	struct moc_function *func;
+	struct moc_listnode *mnode, *rnode;
+	struct moc_mapping *map;
+	MOC_SIZE_T f;
+	unsigned char i;
+	if (nparams > MOC_MAXPARAMS) {
+		moc_send_error(MOC_ERR_INVNPARAM, funcname, nparams, 0, 0);
+		return moc_false;
+	}
+	if (! moc_isvalidtype(rettype)) {
+		moc_send_error(MOC_ERR_INVALTYPE, funcname, 0,
+				rettype, rettype);
+		return moc_false;
+	}
+	for (i = 0; i < nparams; i++) {
+		if (! moc_isvalidtype(paramtypes[i])) {
+			moc_send_error(MOC_ERR_INVALTYPE, funcname, i + 1,
+					paramtypes[i], paramtypes[i]);
+			return moc_false;
+		}
+	}
+	if (! moc_ctx.dryrun) {
+		f = moc_findfunc(funcname, nparams);
+		if (f == moc_ctx.nfuncs) {
+			if (f == moc_ctx.maxfuncs) {
+				moc_send_error(MOC_ERR_NFUNLIMIT, funcname,
+						0, 0, 0);
+				return moc_false;
+			}
+			func = moc_ctx.funcs + f;
+			func->name = funcname;
+			func->nparams = nparams;
+			func->compiled = 0;
+			func->self = 0;
+			moc_inilist(&(func->lmaps));
+			moc_ctx.nfuncs++;
+		}
+		func = moc_ctx.funcs + f;
+		func->ptypes = paramtypes;
+		func->rettype = rettype;
+		/* Checks the mappings added before the declaration: */
+		for (mnode = func->lmaps.first; mnode != MOC_NULLNODE;
+				mnode = mnode->next) {
+			map = (struct moc_mapping *) mnode->item;
+			for (rnode = map->lresps.first; rnode != MOC_NULLNODE;
+					rnode = rnode->next) {
+				if (! moc_chkdecl(func, map->matchers,
+						map->nxmatchers, map->matchers
+						+ func->nparams, rnode->nitems,
+						(struct moc_responder *)
+						rnode->item)) {
+					func->ptypes = 0;
+					return moc_false;
+				}
+			}
+		}
+	}
+	moc_fpmix(&(moc_ctx.fingerprint), funcname,
+			moc_strlen(funcname) + 1);
+	moc_fpmix(&(moc_ctx.fingerprint), &rettype, sizeof(rettype));
+	moc_fpmix(&(moc_ctx.fingerprint), paramtypes,
+			nparams * sizeof(moc_type));
+	return moc_true;
+}
+
+void moc_set_trusted(moc_bool trusted) {
+	moc_ctx.trusted = trusted;
+}
+
+void moc_given_self(const void *self, const char *funcname,
+		struct moc_matchers_grp mgrp, struct moc_responders_grp rgrp) {
+	moc_ctx.self = self;
+	moc_given_nnn(funcname, mgrp.nelems, mgrp.elems, 0, mgrp.elems,
+			rgrp.nelems, rgrp.elems, MOC_NULLNODE);
+	moc_ctx.self = 0;
+}
+
+/* Executes the mappings counting the depth of the calls to the mocks
+ * nested in the matchers and responders. The caller set for the call
+ * is used only by it, restoring the one of the outer call after it. */
+static struct moc_value moc_act_f(MOC_SIZE_T f, const char *funcname,
+		moc_type rettype, unsigned char nparams,
+		struct moc_value *params) {
+	struct moc_value retval;
+	int outercaller;
+	outercaller = moc_ctx.callerid;
+	moc_ctx.callerid = moc_ctx.nextcaller;
+	moc_ctx.nextcaller = -1;
+	moc_ctx.depth++;
+	retval = moc_dispatch(f, funcname, rettype, nparams, params);
+	moc_ctx.depth--;
+	moc_ctx.callerid = moc_ctx.depth > 0 ? outercaller : -1;
+	return retval;
+}
+
+static struct moc_value moc_act_n(const char *funcname, moc_type rettype,
+		unsigned char nparams, struct moc_value *params) {
+	MOC_SIZE_T f;
+	f = moc_findfunc(funcname, nparams);
+	if (f == moc_ctx.nfuncs) {
+		return moc_act_tbl(funcname, rettype, nparams, params,
+				MOC_ERR_FUNNOTFND);
+	}
+	return moc_act_f(f, funcname, rettype, nparams, params);
+}
+
+/* Called at the beginning of a call for calling to the poll function
+ * and reading the start time of the call, unless moc_has_mappings
+ * already did it for this call. The nested calls do not poll, so the
+ * configuration does not change while the outer call uses it. */
+static void moc_enter(void) {
+	if (moc_ctx.polled) {
+		moc_ctx.polled = moc_false;
+		return;
+	}
+	if (moc_ctx.pollfn != 0 && moc_ctx.depth == 0) {
+		moc_ctx.pollfn();
+	}
+	if (moc_ctx.clockfn != 0) {
+		moc_ctx.callstart = moc_ctx.clockfn();
+		moc_ctx.started = moc_true;
+	}
 }
 
 struct moc_value moc_act(const char *funcname, moc_type rettype,
 		struct moc_values_grp pgrp) {
+	moc_enter();
 	return moc_act_n(funcname, rettype, pgrp.nelems, pgrp.elems);
 }
 
+struct moc_value moc_act_v(const char *funcname, moc_type rettype,
+		unsigned char nparams, struct moc_value *params) {
+	moc_enter();
+	if (nparams > MOC_MAXPARAMS) {
+		moc_send_error(MOC_ERR_INVNPARAM, funcname, nparams, 0, 0);
+		return moc_emptyval;
+	}
+	return moc_act_n(funcname, rettype, nparams, params);
+}
+
+/* Reads the variable arguments of the types in the array of parameters,
+ * returning moc_false after reporting an error for an invalid type. */
+static moc_bool moc_readargs(const char *funcname, unsigned char nvar,
+		const moc_type *vartypes, va_list ap,
+		struct moc_value *params, unsigned char pos) {
+	unsigned char i;
+	for (i = 0; i < nvar; i++, params++) {
+		MOC_EMPTYVAL(*params);
+		if (MOC_PTRTYPE(vartypes[i]) != MOC_NOPTR) {
+			MOC_GET_P(*params) = va_arg(ap, void *);
+		} else {
+			/* The smaller types are promoted to int or double: */
+			switch (MOC_STDTYPE(vartypes[i])) {
+				case MOC_CHR: MOC_GET_C(*params) =
+						(char) va_arg(ap, int); break;
+				case MOC_SHR: MOC_GET_S(*params) =
+						(short) va_arg(ap, int); break;
+				case MOC_INT: MOC_GET_I(*params) =
+						va_arg(ap, int); break;
+				case MOC_LNG: MOC_GET_L(*params) =
+						va_arg(ap, long); break;
+				case MOC_FLT: MOC_GET_F(*params) =
+						(float) va_arg(ap, double); break;
+				case MOC_DBL: MOC_GET_D(*params) =
+						va_arg(ap, double); break;
+				case MOC_SCHR: MOC_GET_SC(*params) =
+						(signed char) va_arg(ap, int); break;
+				case MOC_UCHR: MOC_GET_UC(*params) =
+						(unsigned char) va_arg(ap, int); break;
+				case MOC_USHR: MOC_GET_US(*params) =
+						(unsigned short) va_arg(ap, int); break;
+				case MOC_UINT: MOC_GET_UI(*params) =
+						va_arg(ap, unsigned int); break;
+				case MOC_ULNG: MOC_GET_UL(*params) =
+						va_arg(ap, unsigned long); break;
+				default:
+					moc_send_error(MOC_ERR_INVALTYPE, funcname,
+							pos + i + 1, vartypes[i],
+							vartypes[i]);
+					return moc_false;
+			}
+		}
+		MOC_VALBYTE(*params) = vartypes[i];
+	}
+	return moc_true;
+}
+
+struct moc_value moc_act_va(const char *funcname, moc_type rettype,
+		unsigned char nfixed, const struct moc_value *fixed,
+		unsigned char nvar, const moc_type *vartypes, va_list ap) {
+	struct moc_value params[MOC_MAXPARAMS];
+	unsigned char i;
+	moc_enter();
+	if (nfixed > MOC_MAXPARAMS || nvar > MOC_MAXPARAMS - nfixed) {
+		moc_send_error(MOC_ERR_INVNPARAM, funcname, nfixed + nvar,
+				0, 0);
+		return moc_emptyval;
+	}
+	for (i = 0; i < nfixed; i++) {
+		params[i] = fixed[i];
+	}
+	if (! moc_readargs(funcname, nvar, vartypes, ap,
+			params + nfixed, nfixed)) {
+		return moc_emptyval;
+	}
+	return moc_act_n(funcname, rettype, nfixed + nvar, params);
+}
+
+/* Parses the conversions of the printf format in the array of types of
+ * their arguments, returning the number of types or -1 if invalid. */
+static int moc_parsefrmt(const char *format, moc_type *types, int maxtypes) {
+	int n;
+	char len; /* length modifier, with 'H' for hh */
+	moc_type type;
+	for (n = 0; *format != '\0'; format++) {
+		if (*format != '%') {
+			continue;
+		}
+		format++;
+		if (*format == '%') {
+			continue;
+		}
+		/* The flags, the width and the precision, which can be
+		 * received in int arguments: */
+		while (*format == '-' || *format == '+' || *format == ' '
+				|| *format == '#' || *format == '0') {
+			format++;
+		}
+		for (; (*format >= '0' && *format <= '9') || *format == '.'
+				|| *format == '*'; format++) {
+			if (*format == '*') {
+				if (n == maxtypes) {
+					return -1;
+				}
+				types[n++] = MOC_TYPE_I;
+			}
+		}
+		len = '\0';
+		if (*format == 'h' && format[1] == 'h') {
+			len = 'H';
+			format += 2;
+		} else if (*format == 'h' || *format == 'l') {
+			len = *format;
+			format++;
+		}
+		switch (*format) {
+			case 'd': case 'i':
+				type = len == 'l' ? MOC_TYPE_L : MOC_TYPE_I;
+				break;
+			case 'o': case 'u': case 'x': case 'X':
+				type = len == 'l' ? MOC_TYPE_UL : MOC_TYPE_UI;
+				break;
+			case 'c': type = MOC_TYPE_C; break;
+			case 'e': case 'E': case 'f': case 'g': case 'G':
+				type = MOC_TYPE_D; break;
+			case 's': type = MOC_TYPE_CP_C; break;
+			case 'p': type = MOC_TYPE_P; break;
+			case 'n':
+				type = len == 'l' ? MOC_TYPE_P_L : len == 'h'
+					? MOC_TYPE_P_S : len == 'H'
+					? MOC_TYPE_P_C : MOC_TYPE_P_I;
+				break;
+			default: return -1;
+		}
+		if (n == maxtypes) {
+			return -1;
+		}
+		types[n++] = type;
+	}
+	return n;
+}
+
+struct moc_value moc_act_fmt(const char *funcname, moc_type rettype,
+		unsigned char nfixed, const struct moc_value *fixed,
+		const char *format, va_list ap) {
+	struct moc_value params[MOC_MAXPARAMS];
+	moc_type types[MOC_MAXPARAMS];
+	struct moc_frmtslot *slot;
+	unsigned char i, nvar;
+	const moc_type *vartypes;
+	int n;
+	moc_enter();
+	if (nfixed >= MOC_MAXPARAMS) {
+		moc_send_error(MOC_ERR_INVNPARAM, funcname, nfixed + 1, 0, 0);
+		return moc_emptyval;
+	}
+	/* The format is parsed only once while it is in the cache: */
+	slot = moc_ctx.frmtcache + moc_fnv(MOC_FNVINIT, &format,
+			sizeof(format)) % MOC_FRMTMAX;
+	if (slot->epoch == moc_ctx.epoch && slot->format == format) {
+		nvar = slot->ntypes;
+		vartypes = slot->types;
+		if (nvar > MOC_MAXPARAMS - 1 - nfixed) {
+			moc_send_error(MOC_ERR_INVNPARAM, funcname,
+					nfixed + 1 + nvar, 0, 0);
+			return moc_emptyval;
+		}
+	} else {
+		n = moc_parsefrmt(format, types, MOC_MAXPARAMS - 1 - nfixed);
+		if (n < 0) {
+			moc_send_error(MOC_ERR_INVALFRMT, funcname, nfixed + 1,
+					0, 0);
+			return moc_emptyval;
+		}
+		nvar = (unsigned char) n;
+		vartypes = types;
+		if (nvar <= MOC_FRMTARGS) {
+			for (i = 0; i < nvar; i++) {
+				slot->types[i] = types[i];
+			}
+			slot->ntypes = nvar;
+			slot->format = format;
+			slot->epoch = moc_ctx.epoch;
+		}
+	}
+	for (i = 0; i < nfixed; i++) {
+		params[i] = fixed[i];
+	}
+	params[nfixed] = moc_cp_c(format);
+	if (! moc_readargs(funcname, nvar, vartypes, ap,
+			params + nfixed + 1, nfixed + 1)) {
+		return moc_emptyval;
+	}
+	return moc_act_n(funcname, rettype, nfixed + 1 + nvar, params);
+}
+
+/* Returns the position of the function of the handle, searching it only
+ * once after each moc_init, or moc_ctx.nfuncs if it is not found. */
+static MOC_SIZE_T moc_findhnd(struct moc_handle *handle,
+		unsigned char nparams) {
+	MOC_SIZE_T f;
+	if (handle->epoch != moc_ctx.epoch || ! handle->found
+			|| moc_ctx.funcs[handle->pos].nparams != nparams) {
+		f = moc_findfunc(handle->funcname, nparams);
+		if (f == moc_ctx.nfuncs) {
+			return f;
+		}
+		handle->epoch = moc_ctx.epoch;
+		handle->pos = f;
+		handle->found = 1;
+	}
+	return handle->pos;
+}
+
+struct moc_value moc_act_h(struct moc_handle *handle, moc_type rettype,
+		struct moc_values_grp pgrp) {
+	MOC_SIZE_T f;
+	moc_enter();
+	f = moc_findhnd(handle, pgrp.nelems);
+	if (f == moc_ctx.nfuncs) {
+		return moc_act_tbl(handle->funcname, rettype,
+				pgrp.nelems, pgrp.elems, MOC_ERR_FUNNOTFND);
+	}
+	return moc_act_f(f, handle->funcname, rettype,
+			pgrp.nelems, pgrp.elems);
+}
+
+void moc_act_batch(struct moc_handle *handle, moc_type rettype,
+		unsigned long ncalls, unsigned char nparams,
+		struct moc_value *params, struct moc_value *results) {
+	MOC_SIZE_T f;
+	unsigned long c;
+	moc_enter();
+	f = moc_findhnd(handle, nparams);
+	for (c = 0; c < ncalls; c++, params += nparams) {
+		results[c] = f == moc_ctx.nfuncs
+			? moc_act_tbl(handle->funcname, rettype, nparams,
+					params, MOC_ERR_FUNNOTFND)
+			: moc_act_f(f, handle->funcname, rettype,
+					nparams, params);
+	}
+}
+
+struct moc_value moc_act_self(struct moc_handle *handle, const void *self,
+		moc_type rettype, struct moc_values_grp pgrp) {
+	struct moc_selfslot *slot, full;
+	MOC_SIZE_T f;
+	unsigned long h;
+	unsigned int i;
+	moc_enter();
+	/* Finds the function of the instance in the cache: */
+	h = moc_fnv(moc_fnv(MOC_FNVINIT, &self, sizeof(self)),
+			&handle, sizeof(handle));
+	for (i = 0; i < MOC_SELFMAX; i++) {
+		slot = moc_ctx.selfcache + (h + i) % MOC_SELFMAX;
+		if (slot->epoch != moc_ctx.epoch || (slot->self == self
+				&& slot->handle == handle)) {
+			break;
+		}
+	}
+	if (i == MOC_SELFMAX) {
+		slot = &full; /* searched again at each call */
+		slot->epoch = moc_ctx.epoch + 1;
+	}
+	if (slot->epoch != moc_ctx.epoch) {
+		slot->self = self;
+		slot->handle = handle;
+		slot->epoch = moc_ctx.epoch;
+		slot->pos = 0;
+		slot->found = moc_false;
+	}
+	/* Searches only the functions added after the last search: */
+	for (f = slot->pos; self != 0 && ! slot->found
+			&& f < moc_ctx.nfuncs; f++) {
+		if (moc_ctx.funcs[f].self == self
+				&& moc_ctx.funcs[f].nparams == pgrp.nelems
+				&& moc_strcmp(moc_ctx.funcs[f].name,
+					handle->funcname) == 0) {
+			slot->found = moc_true;
+			break;
+		}
+	}
+	slot->pos = f;
+	if (slot->found) {
+		return moc_act_f(slot->pos, handle->funcname, rettype,
+				pgrp.nelems, pgrp.elems);
+	}
+	/* The other instances use the mappings of the function: */
+	f = moc_findhnd(handle, pgrp.nelems);
+	if (f == moc_ctx.nfuncs) {
+		return moc_act_tbl(handle->funcname, rettype,
+				pgrp.nelems, pgrp.elems, MOC_ERR_FUNNOTFND);
+	}
+	return moc_act_f(f, handle->funcname, rettype,
+			pgrp.nelems, pgrp.elems);
+}
+
+moc_bool moc_has_mappings(struct moc_handle *handle, unsigned char nparams) {
+	MOC_SIZE_T f;
+	unsigned int r;
+	moc_ctx.polled = moc_false;
+	moc_enter();
+	if (handle->epoch != moc_ctx.epoch) {
+		handle->epoch = moc_ctx.epoch;
+		handle->pos = 0;
+		handle->found = 0;
+	}
+	/* The call that follows does not need to poll again: */
+	moc_ctx.polled = moc_true;
+	if (handle->found) {
+		return moc_true;
+	}
+	/* Searches only the functions added after the last search: */
+	for (f = handle->pos; f < moc_ctx.nfuncs; f++) {
+		if (moc_ctx.funcs[f].nparams == nparams
+				&& moc_ctx.funcs[f].self == 0
+				&& moc_strcmp(moc_ctx.funcs[f].name,
+					handle->funcname) == 0) {
+			if (moc_ctx.funcs[f].lmaps.first == MOC_NULLNODE) {
+				break; /* declared only, searched again */
+			}
+			handle->pos = f;
+			handle->found = 1;
+			return moc_true;
+		}
+	}
+	handle->pos = f;
+	/* Searches the table only once after it is attached: */
+	if (handle->tblstamp != moc_ctx.tblstamp
+			|| handle->tblfound / 2 != nparams) {
+		handle->tblstamp = moc_ctx.tblstamp;
+		handle->tblfound = nparams * 2u;
+		for (r = 0; r < moc_ctx.ntblrows; r++) {
+			if (moc_ctx.tblrows[r].nparams == nparams
+					&& moc_strcmp(moc_ctx.tblrows[r].funcname,
+						handle->funcname) == 0) {
+				handle->tblfound++;
+				break;
+			}
+		}
+	}
+	if (handle->tblfound % 2 == 0) {
+		moc_ctx.polled = moc_false;
+		return moc_false;
+	}
+	return moc_true;
+}
+
+
+/* Writer of text in a buffer of limited size that counts the length of
+ * the whole text, even when it does not fit completely in the buffer. */
+struct moc_writer {
+	char *buf;
+	unsigned long size, len;
+};
+
+static void moc_wrinit(struct moc_writer *w, char *buf,
+		unsigned long size) {
+	w->buf = buf;
+	w->size = size;
+	w->len = 0;
+	if (size > 0) {
+		buf[0] = '\0';
+	}
+}
+
+static void moc_wrchr(struct moc_writer *w, char c) {
+	if (w->len + 1 < w->size) {
+		w->buf[w->len] = c;
+		w->buf[w->len + 1] = '\0';
+	}
+	w->len++;
+}
+
+static void moc_wrstr(struct moc_writer *w, const char *str) {
+	while (*str != '\0') {
+		moc_wrchr(w, *str++);
+	}
+}
+
+static void moc_wrul(struct moc_writer *w, unsigned long n) {
+	char digits[24];
+	int i = 0;
+	do {
+		digits[i++] = (char) ('0' + n % 10);
+		n /= 10;
+	} while (n != 0);
+	while (i > 0) {
+		moc_wrchr(w, digits[--i]);
+	}
+}
+
+/* Writes a signed integer constant, valid even for the minimum, that
+ * is written as a subtraction because its negation would overflow. */
+static void moc_wrlong(struct moc_writer *w, long n, const char *suffix) {
+	unsigned long u;
+	if (n >= 0) {
+		moc_wrul(w, (unsigned long) n);
+		moc_wrstr(w, suffix);
+		return;
+	}
+	u = ((unsigned long) -(n + 1)) + 1UL;
+	moc_wrstr(w, "(-");
+	if ((u & (u - 1UL)) == 0) { /* it could be the minimum */
+		moc_wrul(w, u - 1UL);
+		moc_wrstr(w, suffix);
+		moc_wrstr(w, " - 1");
+	} else {
+		moc_wrul(w, u);
+	}
+	moc_wrstr(w, suffix);
+	moc_wrchr(w, ')');
+}
+
+/*
+ * Writes a constant expression with the exact value of the given double
+ * as an integer mantissa scaled by powers of two, or returns moc_false
+ * if the value is not finite.
+ */
+static moc_bool moc_wrdbl(struct moc_writer *w, double d) {
+	static const double zero = 0.0;
+	const unsigned char *b1, *b2;
+	double m, hi, lo;
+	unsigned long i;
+	int e = 0;
+	if (d != d || d - d != 0.0) {
+		return moc_false; /* NaN or infinite */
+	}
+	if (d == 0.0) {
+		b1 = (const unsigned char *) &d;
+		b2 = (const unsigned char *) &zero;
+		for (i = 0; i < sizeof(double) && b1[i] == b2[i]; i++) {
+		}
+		moc_wrstr(w, i < sizeof(double) ? "(-0.0)" : "0.0");
+		return moc_true;
+	}
+	m = d < 0.0 ? -d : d;
+	while (m >= 9007199254740992.0) { /* 2^53 */
+		m /= 2.0;
+		e++;
+	}
+	for (;;) {
+		hi = (double) (unsigned long) (m / 4294967296.0);
+		lo = m - hi * 4294967296.0;
+		if (lo == (double) (unsigned long) lo) {
+			break; /* m is an integer */
+		}
+		m *= 2.0;
+		e--;
+	}
+	moc_wrstr(w, d < 0.0 ? "(-(" : "((");
+	if (hi != 0.0) {
+		moc_wrul(w, (unsigned long) hi);
+		moc_wrstr(w, ".0 * 4294967296.0 + ");
+	}
+	moc_wrul(w, (unsigned long) lo);
+	moc_wrstr(w, ".0)");
+	for (; e >= 32 || e <= -32; e += (e > 0 ? -32 : 32)) {
+		moc_wrstr(w, e > 0 ? " * 4294967296.0" : " / 4294967296.0");
+	}
+	if (e != 0) {
+		moc_wrstr(w, e > 0 ? " * " : " / ");
+		moc_wrul(w, 1UL << (e > 0 ? e : -e));
+		moc_wrstr(w, ".0");
+	}
+	moc_wrchr(w, ')');
+	return moc_true;
+}
+
+/* Writes a string literal escaping the non printable characters. */
+static void moc_wrlit(struct moc_writer *w, const char *str) {
+	unsigned char c;
+	moc_wrchr(w, '"');
+	for (; *str != '\0'; str++) {
+		c = (unsigned char) *str;
+		if (c == '\\' || c == '"' || c == '?') {
+			moc_wrchr(w, '\\');
+			moc_wrchr(w, (char) c);
+		} else if (c >= 32 && c < 127) {
+			moc_wrchr(w, (char) c);
+		} else {
+			moc_wrchr(w, '\\');
+			moc_wrchr(w, (char) ('0' + (c >> 6)));
+			moc_wrchr(w, (char) ('0' + ((c >> 3) & 7)));
+			moc_wrchr(w, (char) ('0' + (c & 7)));
+		}
+	}
+	moc_wrchr(w, '"');
+}
+
+static const char *moc_gtypesufs[] = {
+	"void", "c", "s", "i", "l", "f", "d",
+	"sc", "uc", "us", "ui", "ul", "fn"
+};
+
+/* Writes the constant of a value that is not a pointer or a function,
+ * returning moc_false if that value cannot be written as a constant. */
+static moc_bool moc_wrval(struct moc_writer *w, struct moc_value val) {
+	if (MOC_VALPTRTYPE(val) != MOC_NOPTR) {
+		return moc_false;
+	}
+	switch (MOC_VALSTDTYPE(val)) {
+		case MOC_CHR: moc_wrlong(w, MOC_GET_C(val), ""); break;
+		case MOC_SHR: moc_wrlong(w, MOC_GET_S(val), ""); break;
+		case MOC_INT: moc_wrlong(w, MOC_GET_I(val), ""); break;
+		case MOC_LNG: moc_wrlong(w, MOC_GET_L(val), "L"); break;
+		case MOC_FLT: moc_wrstr(w, "(float) ");
+			return moc_wrdbl(w, MOC_GET_F(val));
+		case MOC_DBL: return moc_wrdbl(w, MOC_GET_D(val));
+		case MOC_SCHR: moc_wrlong(w, MOC_GET_SC(val), ""); break;
+		case MOC_UCHR: moc_wrul(w, MOC_GET_UC(val)); break;
+		case MOC_USHR: moc_wrul(w, MOC_GET_US(val)); break;
+		case MOC_UINT: moc_wrul(w, MOC_GET_UI(val));
+			moc_wrchr(w, 'U'); break;
+		case MOC_ULNG: moc_wrul(w, MOC_GET_UL(val));
+			moc_wrstr(w, "UL"); break;
+		default: return moc_false;
+	}
+	return moc_true;
+}
+
+/* Writes the constructor of a value returned by a dispatch function. */
+static moc_bool moc_wrret(struct moc_writer *w, struct moc_value val) {
+	if (MOC_VALBYTE(val) == MOC_TYPES2BYTE(MOC_VOID, MOC_NOPTR)) {
+		moc_wrstr(w, "moc_void()");
+		return moc_true;
+	}
+	moc_wrstr(w, "moc_");
+	moc_wrstr(w, moc_gtypesufs[MOC_VALSTDTYPE(val) <= MOC_FUN
+			? MOC_VALSTDTYPE(val) : MOC_VOID]);
+	moc_wrchr(w, '(');
+	if (! moc_wrval(w, val)) {
+		return moc_false;
+	}
+	moc_wrchr(w, ')');
+	return moc_true;
+}
+
+/* Returns the comparison operator of a predefined matcher function. */
+static const char *moc_aotop(moc_mtcfn_param_t fn, moc_bool *pstr) {
+	*pstr = moc_false;
+	if (fn == moc_cmpeq) return "==";
+	if (fn == moc_cmpne) return "!=";
+	if (fn == moc_cmplt) return "<";
+	if (fn == moc_cmple) return "<=";
+	if (fn == moc_cmpgt) return ">";
+	if (fn == moc_cmpge) return ">=";
+	*pstr = moc_true;
+	if (fn == moc_cmpeqstr) return "==";
+	if (fn == moc_cmpnestr) return "!=";
+	if (fn == moc_cmpltstr) return "<";
+	if (fn == moc_cmplestr) return "<=";
+	if (fn == moc_cmpgtstr) return ">";
+	if (fn == moc_cmpgestr) return ">=";
+	return 0;
+}
+
+/* Writes the condition of a matcher of the given parameter, returning
+ * moc_false if it cannot be specialized. Type mismatches clear t. */
+static moc_bool moc_wrcond(struct moc_writer *w, struct moc_matcher *pm,
+		MOC_SIZE_T i, moc_bool *pfirst, moc_bool *pusesstr) {
+	struct moc_imatcher *im;
+	const char *op;
+	moc_bool isstr;
+	moc_type type;
+	im = MOC_IMTC(pm);
+	if (im->mopts == 128 && im->mtcfn.prm == moc_mtctrue) {
+		return moc_true; /* any value without type */
+	}
+	if (im->mopts != 0) {
+		return moc_false;
+	}
+	type = MOC_VALBYTE(im->mval);
+	op = moc_aotop(im->mtcfn.prm, &isstr);
+	if (! moc_isvalidtype(type) || (im->mtcfn.prm != moc_mtctrue
+			&& (op == 0 || (isstr
+			&& type != MOC_TYPES2BYTE(MOC_CHR, MOC_PTR)
+			&& type != MOC_TYPES2BYTE(MOC_CHR, MOC_CPTR))))) {
+		return moc_false;
+	}
+	moc_wrstr(w, *pfirst ? "" : "\n\t\t\t&& ");
+	*pfirst = moc_false;
+	moc_wrstr(w, "(t = (moc_get_type(p[");
+	moc_wrul(w, i);
+	moc_wrstr(w, "]) == ");
+	moc_wrul(w, type);
+	moc_wrstr(w, "))");
+	if (im->mtcfn.prm == moc_mtctrue) {
+		return moc_true; /* any value of the type */
+	}
+	moc_wrstr(w, "\n\t\t\t&& ");
+	if (isstr) {
+		if (MOC_GET_CP(im->mval) == 0) {
+			return moc_false;
+		}
+		*pusesstr = moc_true;
+		moc_wrstr(w, "moc_aot_strcmp(moc_get_cp_c(p[");
+		moc_wrul(w, i);
+		moc_wrstr(w, "]), ");
+		moc_wrlit(w, MOC_GET_CP(im->mval));
+		moc_wrstr(w, ") ");
+		moc_wrstr(w, op);
+		moc_wrstr(w, " 0");
+		return moc_true;
+	}
+	if (MOC_VALPTRTYPE(im->mval) != MOC_NOPTR
+			|| MOC_VALSTDTYPE(im->mval) >= MOC_FUN) {
+		return moc_false; /* also the structs */
+	}
+	moc_wrstr(w, "moc_get_");
+	moc_wrstr(w, moc_gtypesufs[MOC_VALSTDTYPE(im->mval)]);
+	moc_wrstr(w, "(p[");
+	moc_wrul(w, i);
+	moc_wrstr(w, "]) ");
+	moc_wrstr(w, op);
+	moc_wrchr(w, ' ');
+	return moc_wrval(w, im->mval);
+}
+
+/* Returns the value returned by a group of responders, if all of them
+ * just return values, or an invalid type otherwise. */
+static moc_type moc_aotrettype(struct moc_listnode *rnode) {
+	struct moc_responder *responders;
+	MOC_SIZE_T r;
+	responders = (struct moc_responder *) rnode->item;
+	for (r = 0; r < rnode->nitems; r++) {
+		if (MOC_IRSP(responders + r)->ropts != 128 + MOC_NOPARAM
+				|| MOC_IRSP(responders + r)->rspfn.cll
+					!= moc_rsprt) {
+			return 0xFF;
+		}
+	}
+	if (rnode->nitems == 0) {
+		return MOC_TYPES2BYTE(MOC_VOID, MOC_NOPTR);
+	}
+	return MOC_VALBYTE(MOC_IRSP(responders + r - 1)->rval);
+}
+
+/* Returns the value returned by a group of responders. */
+static struct moc_value moc_aotretval(struct moc_listnode *rnode) {
+	if (rnode->nitems == 0) {
+		return moc_emptyval;
+	}
+	return MOC_IRSP((struct moc_responder *) rnode->item
+			+ rnode->nitems - 1)->rval;
+}
+
+/* Writes the statements returning the values of the responders of the
+ * given mapping, rotating them with a switch if there are several. */
+static moc_bool moc_wraotret(struct moc_writer *w, struct moc_mapping *map,
+		MOC_SIZE_T j, const char *indent) {
+	struct moc_listnode *rnode;
+	MOC_SIZE_T k;
+	rnode = map->lresps.first;
+	if (rnode->next == MOC_NULLNODE) {
+		moc_wrstr(w, indent);
+		moc_wrstr(w, "return ");
+		if (! moc_wrret(w, moc_aotretval(rnode))) {
+			return moc_false;
+		}
+		moc_wrstr(w, ";\n");
+		return moc_true;
+	}
+	moc_wrstr(w, indent);
+	moc_wrstr(w, "switch (seq[");
+	moc_wrul(w, j);
+	moc_wrstr(w, "]) {\n");
+	for (k = 0; rnode != MOC_NULLNODE; rnode = rnode->next, k++) {
+		moc_wrstr(w, indent);
+		if (rnode->next == MOC_NULLNODE) {
+			moc_wrstr(w, "default: seq[");
+			moc_wrul(w, j);
+			moc_wrstr(w, "] = 0; return ");
+		} else {
+			moc_wrstr(w, "case ");
+			moc_wrul(w, k);
+			moc_wrstr(w, ": seq[");
+			moc_wrul(w, j);
+			moc_wrstr(w, "] = ");
+			moc_wrul(w, k + 1);
+			moc_wrstr(w, "; return ");
+		}
+		if (! moc_wrret(w, moc_aotretval(rnode))) {
+			return moc_false;
+		}
+		moc_wrstr(w, ";\n");
+	}
+	moc_wrstr(w, indent);
+	moc_wrstr(w, "}\n");
+	return moc_true;
+}
+
+/* Returns moc_true if the given name is a valid C identifier. */
+static moc_bool moc_isident(const char *name) {
+	const char *c;
+	for (c = name; *c != '\0'; c++) {
+		if (! ((*c >= 'a' && *c <= 'z') || (*c >= 'A' && *c <= 'Z')
+				|| *c == '_' || (c != name
+					&& *c >= '0' && *c <= '9'))) {
+			return moc_false;
+		}
+	}
+	return c != name;
+}
+
+/* Writes the dispatch function of the given mocked function, returning
+ * moc_false if it cannot be specialized (then w could be incomplete). */
+static moc_bool moc_wraotfn(struct moc_writer *w, struct moc_function *func,
+		moc_bool *pusesstr) {
+	struct moc_listnode *mnode, *rnode;
+	struct moc_mapping *map;
+	moc_type rettype = 0xFF, type;
+	MOC_SIZE_T f, m, j, nmaps = 0;
+	moc_bool first, hasseq = moc_false, hastyped = moc_false;
+	/* Checks that the name is an identifier used only once: */
+	if (! moc_isident(func->name)) {
+		return moc_false;
+	}
+	for (f = 0; f < moc_ctx.nfuncs; f++) {
+		if (moc_ctx.funcs + f != func && moc_strcmp(
+				moc_ctx.funcs[f].name, func->name) == 0) {
+			return moc_false;
+		}
+	}
+	if (func->self != 0) {
+		return moc_false; /* mappings of an instance */
+	}
+	/* Checks the responders and the matchers: */
+	for (mnode = func->lmaps.first; mnode != MOC_NULLNODE;
+			mnode = mnode->next) {
+		map = (struct moc_mapping *) mnode->item;
+		if (map->nxmatchers > 0) {
+			return moc_false;
+		}
+		nmaps++;
+		hasseq = hasseq || map->lresps.first->next != MOC_NULLNODE;
+		for (m = 0; m < func->nparams; m++) {
+			hastyped = hastyped
+				|| MOC_IMTC(map->matchers + m)->mopts == 0;
+		}
+		for (rnode = map->lresps.first; rnode != MOC_NULLNODE;
+				rnode = rnode->next) {
+			type = moc_aotrettype(rnode);
+			if (type == 0xFF || (rettype != 0xFF
+					&& type != rettype)) {
+				return moc_false;
+			}
+			rettype = type;
+		}
+	}
+	moc_wrstr(w, "\nstruct moc_value moc_aot_");
+	moc_wrstr(w, func->name);
+	moc_wrstr(w, "(moc_type rettype,\n\t\tstruct moc_values_grp pgrp)"
+			" {\n");
+	if (hasseq) {
+		moc_wrstr(w, "\tstatic unsigned int seq[");
+		moc_wrul(w, nmaps);
+		moc_wrstr(w, "];\n\tstatic unsigned long epoch;\n"
+				"\tunsigned int i;\n");
+	}
+	if (func->nparams > 0) {
+		moc_wrstr(w, "\tstruct moc_value *p;\n");
+	}
+	if (hastyped) {
+		moc_wrstr(w, "\tint t;\n");
+	}
+	if (hasseq) {
+		/* The sequences restart after moc_init like the mappings: */
+		moc_wrstr(w, "\tif (epoch != moc_epoch()) {\n"
+				"\t\tepoch = moc_epoch();\n\t\tfor (i = 0; i < ");
+		moc_wrul(w, nmaps);
+		moc_wrstr(w, "; i++) {\n\t\t\tseq[i] = 0;\n\t\t}\n\t}\n");
+	}
+	if (func->nparams > 0) {
+		moc_wrstr(w, "\tp = pgrp.elems;\n");
+	}
+	moc_wrstr(w, "\tif (pgrp.nelems != ");
+	moc_wrul(w, func->nparams);
+	moc_wrstr(w, " || rettype != ");
+	moc_wrul(w, rettype);
+	moc_wrstr(w, ") {\n\t\tgoto generic;\n\t}\n");
+	for (mnode = func->lmaps.first, j = 0; mnode != MOC_NULLNODE;
+			mnode = mnode->next, j++) {
+		map = (struct moc_mapping *) mnode->item;
+		for (m = 0; m < func->nparams; m++) {
+			if (MOC_IMTC(map->matchers + m)->mopts == 0) {
+				break; /* it has conditions */
+			}
+		}
+		if (m == func->nparams) {
+			/* Matches always, so the next are unreachable: */
+			if (! moc_wraotret(w, map, j, "\t")) {
+				return moc_false;
+			}
+			break;
+		}
+		moc_wrstr(w, "\tif (");
+		first = moc_true;
+		for (m = 0; m < func->nparams; m++) {
+			if (! moc_wrcond(w, map->matchers + m, m, &first,
+					pusesstr)) {
+				return moc_false;
+			}
+		}
+		moc_wrstr(w, ") {\n");
+		if (! moc_wraotret(w, map, j, "\t\t")) {
+			return moc_false;
+		}
+		moc_wrstr(w, "\t}\n\tif (! t) {\n\t\tgoto generic;\n\t}\n");
+	}
+	moc_wrstr(w, "generic:\n\treturn moc_act(");
+	moc_wrlit(w, func->name);
+	moc_wrstr(w, ", rettype, pgrp);\n}\n");
+	return moc_true;
+}
+
+unsigned long moc_epoch(void) {
+	return moc_ctx.epoch;
+}
+
+unsigned long moc_gen_aot(char *buf, unsigned long size) {
+	struct moc_writer w, dry;
+	MOC_SIZE_T f;
+	moc_bool usesstr = moc_false, fusesstr;
+	moc_wrinit(&w, buf, size);
+	moc_wrstr(&w, "/* Dispatch functions generated by moc_gen_aot()"
+			" from a frozen Mocito configuration. */\n\n"
+			"#include \"mocito.h\"\n");
+	/* Checks which functions can be specialized using strings: */
+	for (f = 0; f < moc_ctx.nfuncs; f++) {
+		moc_wrinit(&dry, 0, 0);
+		fusesstr = moc_false;
+		if (moc_wraotfn(&dry, moc_ctx.funcs + f, &fusesstr)) {
+			usesstr = usesstr || fusesstr;
+		}
+	}
+	if (usesstr) {
+		moc_wrstr(&w, "\nstatic int moc_aot_strcmp(const char *str1,"
+				" const char *str2) {\n"
+				"\twhile (*str1 == *str2 && *str1 != '\\0')"
+				" {\n\t\tstr1++;\n\t\tstr2++;\n\t}\n"
+				"\treturn ((int) *str2) - *str1;\n}\n");
+	}
+	for (f = 0; f < moc_ctx.nfuncs; f++) {
+		moc_wrinit(&dry, 0, 0);
+		if (moc_wraotfn(&dry, moc_ctx.funcs + f, &fusesstr)) {
+			moc_wraotfn(&w, moc_ctx.funcs + f, &fusesstr);
+		} else if (moc_isident(moc_ctx.funcs[f].name)) {
+			moc_wrstr(&w, "\n/* Not specialized: ");
+			moc_wrstr(&w, moc_ctx.funcs[f].name);
+			moc_wrstr(&w, " */\n");
+		}
+	}
+	return w.len;
+}
+
+
+void moc_init_store(char *mem, unsigned long size) {
+	unsigned int i;
+	moc_ctx.store = mem;
+	moc_ctx.storesize = size;
+	moc_ctx.storelen = 0;
+	for (i = 0; i < MOC_STRMAX; i++) {
+		moc_ctx.strtable[i].epoch = 0;
+	}
+}
+
+void moc_set_scenarios(const struct moc_scenario *scenarios,
+		unsigned int nscenarios) {
+	moc_ctx.scenarios = scenarios;
+	moc_ctx.nscenarios = nscenarios;
+}
+
+void moc_set_pollfn(moc_pollfn_t pollfn) {
+	moc_ctx.pollfn = pollfn;
+}
+
+void moc_set_regions(const struct moc_region *regions,
+		unsigned int nregions) {
+	moc_ctx.regions = regions;
+	moc_ctx.nregions = nregions;
+	moc_ctx.nextcaller = -1;
+}
+
+void moc_set_caller(const void *addr) {
+	const char *p;
+	unsigned int lo, hi, mid;
+	p = (const char *) addr;
+	/* Searches the first region starting after the address: */
+	lo = 0;
+	hi = moc_ctx.nregions;
+	while (lo < hi) {
+		mid = lo + (hi - lo) / 2;
+		if ((const char *) moc_ctx.regions[mid].start <= p) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+	moc_ctx.nextcaller = lo > 0
+		&& p < (const char *) moc_ctx.regions[lo - 1].end
+		? moc_ctx.regions[lo - 1].id : -1;
+}
+
+static moc_bool moc_mtccaller(struct moc_call *call, struct moc_value val) {
+	if (sizeof(call)) {} /* unused warning */
+	return moc_ctx.callerid == MOC_GET_I(val) ? moc_true : moc_false;
+}
+
+struct moc_matcher moc_caller(int id) {
+	return moc_xcall(&moc_mtccaller, moc_i(id));
+}
+
+/* Removes all the mappings and the strings of the commands, keeping
+ * the rest of the configuration. */
+static void moc_clear(void) {
+	moc_ctx.nfuncs = moc_ctx.nmaps = moc_ctx.nmatcs =
+		moc_ctx.nresps = moc_ctx.nlnods = 0;
+	moc_ctx.maxlnods = moc_ctx.initlnods;
+	moc_ctx.storelen = 0;
+	moc_fpinit(&(moc_ctx.fingerprint));
+	moc_ctx.epoch++;
+}
+
+/* Reader of the tokens of a command, counting them for the errors. */
+struct moc_cmdreader {
+	const char *cmd; /* beginning of the command */
+	const char *p; /* beginning of the next token */
+	const char *tok; /* current token */
+	unsigned long len; /* length of the current token */
+	MOC_SIZE_T ntok; /* number of the current token */
+	struct moc_recorder *out; /* compiled commands or 0 to execute */
+	unsigned long pos; /* position in the compiled commands */
+	moc_bool full; /* if the compiled commands did not fit */
+};
+
+static moc_bool moc_isspace(char c) {
+	return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+}
+
+/* Returns if the character ends a command. */
+static moc_bool moc_iscmdend(char c) {
+	return c == '\0' || c == '\n' || c == ';' || c == '#';
+}
+
+/* Reads the next token of the command, returning moc_false at its end.
+ * Quoted text and parentheses can contain spaces in a token. */
+static moc_bool moc_cmdtok(struct moc_cmdreader *rd) {
+	const char *p;
+	char close;
+	p = rd->p;
+	while (moc_isspace(*p)) {
+		p++;
+	}
+	rd->tok = p;
+	rd->len = 0;
+	if (moc_iscmdend(*p)) {
+		rd->p = p;
+		return moc_false;
+	}
+	while (! moc_iscmdend(*p) && ! moc_isspace(*p)) {
+		if (*p == '"' || *p == '\'' || *p == '(') {
+			close = *p == '(' ? ')' : *p;
+			for (p++; *p != close && *p != '\0' && *p != '\n'; p++) {
+				if (*p == '\\' && p[1] != '\0' && p[1] != '\n') {
+					p++;
+				}
+			}
+			if (*p != close) {
+				break;
+			}
+		}
+		p++;
+	}
+	rd->len = (unsigned long) (p - rd->tok);
+	rd->p = p;
+	rd->ntok++;
+	return moc_true;
+}
+
+/* Returns if the text of the given length is equal to the word. */
+static moc_bool moc_streqn(const char *text, unsigned long len,
+		const char *word) {
+	unsigned long i;
+	for (i = 0; i < len && word[i] != '\0' && text[i] == word[i]; i++) {
+		;
+	}
+	return i == len && word[i] == '\0';
+}
+
+/* Returns if the current token is equal to the given word. */
+static moc_bool moc_cmdis(struct moc_cmdreader *rd, const char *word) {
+	return moc_streqn(rd->tok, rd->len, word);
+}
+
+static moc_bool moc_cmderror(struct moc_cmdreader *rd) {
+	moc_send_error(MOC_ERR_INVALCMND, rd->cmd, rd->ntok, 0, 0);
+	return moc_false;
+}
+
+/* Returns the slot of the table of strings with an equal string, or
+ * an empty slot for adding it (with epoch 0), or 0 if the table is full.
+ * The slots of the removed strings are reused, without ending the
+ * search of the strings added after them. */
+static struct moc_strslot *moc_strslot(const char *str) {
+	struct moc_strslot *slot, *removed = 0;
+	unsigned long h, n;
+	h = moc_fnv(MOC_FNVINIT, str, moc_strlen(str));
+	for (n = 0; n < MOC_STRMAX; n++) {
+		slot = moc_ctx.strtable + (h + n) % MOC_STRMAX;
+		if (slot->epoch != moc_ctx.epoch) {
+			break; /* never used after the last reset */
+		}
+		if (slot->end > moc_ctx.storelen) {
+			if (removed == 0) {
+				removed = slot;
+			}
+		} else if (moc_strcmp(slot->str, str) == 0) {
+			return slot;
+		}
+	}
+	if (removed != 0) {
+		slot = removed;
+	} else if (n == MOC_STRMAX) {
+		return 0;
+	}
+	slot->epoch = 0;
+	return slot;
+}
+
+/* Adds the string to the empty slot of the table of strings. */
+static void moc_strslotadd(struct moc_strslot *slot, const char *str,
+		unsigned long end) {
+	slot->str = str;
+	slot->epoch = moc_ctx.epoch;
+	slot->end = end;
+}
+
+/* Copies the text to the store, decoding the escape sequences if it is
+ * quoted, and returns the copy or 0 if it does not fit. */
+static const char *moc_cmdstore(const char *text, unsigned long len,
+		moc_bool quoted) {
+	struct moc_strslot *slot;
+	char *str, *prev, c;
+	unsigned long i;
+	if (moc_ctx.storesize - moc_ctx.storelen < len + 1) {
+		moc_send_error(MOC_ERR_NSTRLIMIT, "", 0, 0, 0);
+		return 0;
+	}
+	str = moc_ctx.store + moc_ctx.storelen;
+	for (i = 0; len > 0; len--) {
+		c = *text++;
+		if (quoted && c == '\\' && len > 1) {
+			len--;
+			c = *text++;
+			c = c == 'n' ? '\n' : c == 't' ? '\t' : c == 'r' ? '\r'
+				: c == '0' ? '\0' : c;
+		}
+		str[i++] = c;
+	}
+	str[i] = '\0';
+	/* Reuses an equal string, so that its mappings can be merged,
+	 * searching all the strings only when the table is full: */
+	slot = moc_strslot(str);
+	if (slot != 0 && slot->epoch != 0) {
+		return slot->str;
+	}
+	for (prev = moc_ctx.store; slot == 0 && prev < str;
+			prev += moc_strlen(prev) + 1) {
+		if (moc_strcmp(prev, str) == 0) {
+			return prev;
+		}
+	}
+	moc_ctx.storelen += i + 1;
+	if (slot != 0) {
+		moc_strslotadd(slot, str, moc_ctx.storelen);
+	}
+	return str;
+}
+
+/* Parses a C literal of a value, returning moc_false if invalid. */
+static moc_bool moc_cmdval(const char *p, const char *end,
+		struct moc_value *val) {
+	const char *str;
+	unsigned long ul = 0, i, base = 10;
+	double d = 0, scale;
+	int stdtype = 0, exp = 0, expsign = 1, digit;
+	moc_bool neg = moc_false, isreal = moc_false, isunsig = moc_false;
+	moc_bool islong = moc_false, isfloat = moc_false;
+	/* Optional cast with the name of a basic type: */
+	if (p < end && *p == '(') {
+		for (i = 1; p + i < end && p[i] != ')'; i++) {
+			;
+		}
+		for (stdtype = MOC_FUN - 1; stdtype > MOC_VOID; stdtype--) {
+			if (moc_strlen(moc_gtypenames[stdtype]) == i - 1
+					&& moc_substridx(p + 1, moc_gtypenames[
+					stdtype]) == 0) {
+				break;
+			}
+		}
+		if (stdtype == MOC_VOID) {
+			return moc_false;
+		}
+		p += i + 1;
+	}
+	if (p < end && *p == '"' && end[-1] == '"' && end - p >= 2
+			&& stdtype == 0) {
+		str = moc_cmdstore(p + 1, (unsigned long) (end - p - 2),
+				moc_true);
+		*val = moc_cp_c(str);
+		return str != 0;
+	}
+	if (end - p >= 3 && *p == '\'' && end[-1] == '\'') {
+		ul = (unsigned char) p[1];
+		if (p[1] == '\\' && end - p == 4) {
+			ul = p[2] == 'n' ? '\n' : p[2] == 't' ? '\t'
+				: p[2] == 'r' ? '\r' : p[2] == '0' ? '\0'
+				: (unsigned char) p[2];
+		} else if (end - p != 3) {
+			return moc_false;
+		}
+		d = (double) ul;
+		stdtype = stdtype == 0 ? MOC_INT : stdtype;
+		p = end;
+	} else {
+		if (p < end && (*p == '-' || *p == '+')) {
+			neg = *p++ == '-';
+		}
+		if (end - p > 2 && p[0] == '0' && (p[1] == 'x' || p[1] == 'X')) {
+			base = 16;
+			p += 2;
+		}
+		for (i = 0; p < end; p++, i++) {
+			digit = *p >= '0' && *p <= '9' ? *p - '0'
+				: base == 16 && *p >= 'a' && *p <= 'f' ? *p - 'a' + 10
+				: base == 16 && *p >= 'A' && *p <= 'F' ? *p - 'A' + 10
+				: -1;
+			if (digit < 0) {
+				break;
+			}
+			ul = ul * base + (unsigned long) digit;
+			d = d * (double) base + digit;
+		}
+		if (i == 0 && (p == end || *p != '.')) {
+			return moc_false;
+		}
+		if (p < end && *p == '.' && base == 10) {
+			isreal = moc_true;
+			for (p++; p < end && *p >= '0' && *p <= '9'; p++) {
+				d = d * 10 + (*p - '0');
+				exp--;
+			}
+		}
+		if (p < end && (*p == 'e' || *p == 'E') && base == 10) {
+			isreal = moc_true;
+			i = 0;
+			if (++p < end && (*p == '-' || *p == '+')) {
+				expsign = *p++ == '-' ? -1 : 1;
+			}
+			for (digit = 0; p < end && *p >= '0' && *p <= '9'; p++) {
+				digit = digit < 1000 ? digit * 10 + (*p - '0')
+					: digit;
+				i++;
+			}
+			if (i == 0) {
+				return moc_false;
+			}
+			exp += expsign * digit;
+		}
+		/* Scales by the exact power of 10 for the usual numbers: */
+		for (scale = 1; exp != 0; exp += exp > 0 ? -1 : 1) {
+			scale *= 10;
+			if (scale >= 1e22 || exp == 1 || exp == -1) {
+				d = exp > 0 ? d * scale : d / scale;
+				scale = 1;
+			}
+		}
+		for (; p < end; p++) {
+			if ((*p == 'f' || *p == 'F') && isreal) {
+				isfloat = moc_true;
+			} else if ((*p == 'u' || *p == 'U') && ! isreal) {
+				isunsig = moc_true;
+			} else if ((*p == 'l' || *p == 'L') && ! isreal) {
+				islong = moc_true;
+			} else {
+				return moc_false;
+			}
+		}
+		if (stdtype == 0) {
+			stdtype = isfloat ? MOC_FLT : isreal ? MOC_DBL
+				: isunsig ? (islong ? MOC_ULNG : MOC_UINT)
+				: islong ? MOC_LNG : MOC_INT;
+		}
+		if (neg) {
+			d = -d;
+			ul = (unsigned long) -(long) ul;
+		}
+	}
+	if (isreal) {
+		ul = (unsigned long) (long) d;
+	}
+	switch (stdtype) {
+		case MOC_CHR: *val = moc_c((char) ul); break;
+		case MOC_SHR: *val = moc_s((short) ul); break;
+		case MOC_INT: *val = moc_i((int) ul); break;
+		case MOC_LNG: *val = moc_l((long) ul); break;
+		case MOC_FLT: *val = moc_f((float) d); break;
+		case MOC_DBL: *val = moc_d(d); break;
+		case MOC_SCHR: *val = moc_sc((signed char) ul); break;
+		case MOC_UCHR: *val = moc_uc((unsigned char) ul); break;
+		case MOC_USHR: *val = moc_us((unsigned short) ul); break;
+		case MOC_UINT: *val = moc_ui((unsigned int) ul); break;
+		default: *val = moc_ul(ul); break;
+	}
+	return moc_true;
+}
+
+/* Operator of the matchers of the commands accepting any value. */
+#define MOC_CMDANY 0xFF
+
+/* Compiled commands: header, hash of the text and the operations. */
+#define MOC_CMDHDR "MOCC\1"
+#define MOC_CMDHDRLEN 5
+#define MOC_CMDGIVEN 'g' /* name, matchers and returned values */
+#define MOC_CMDRESET 'r'
+#define MOC_CMDSCENARIO 's' /* name */
+
+/* Matchers of a given command, with an operator and a value each. */
+struct moc_cmdmatchers {
+	unsigned char n;
+	unsigned char ops[MOC_AUXMAX];
+	struct moc_value vals[MOC_AUXMAX];
+};
+
+static moc_bool moc_isstrval(struct moc_value val) {
+	return MOC_VALBYTE(val) == MOC_TYPES2BYTE(MOC_CHR, MOC_CPTR);
+}
+
+/* Parses a matcher with an optional operator before the value. */
+static moc_bool moc_cmdmtc(struct moc_cmdreader *rd, unsigned char *op,
+		struct moc_value *val) {
+	const char *p, *end;
+	if (moc_cmdis(rd, "any")) {
+		*op = MOC_CMDANY;
+		*val = moc_emptyval;
+		return moc_true;
+	}
+	p = rd->tok;
+	end = p + rd->len;
+	*op = MOC_EQ;
+	if (end - p >= 2 && p[1] == '=' && (*p == '=' || *p == '!'
+			|| *p == '<' || *p == '>')) {
+		*op = *p == '=' ? MOC_EQ : *p == '!' ? MOC_NE
+			: *p == '<' ? MOC_LE : MOC_GE;
+		p += 2;
+	} else if (p < end && (*p == '<' || *p == '>')) {
+		*op = *p == '<' ? MOC_LT : MOC_GT;
+		p++;
+	}
+	return moc_cmdval(p, end, val);
+}
+
+/* Returns the matcher comparing with the operator and the value. */
+static struct moc_matcher moc_cmdmatcher(unsigned char op,
+		struct moc_value val) {
+	const char *str;
+	if (moc_isstrval(val)) {
+		str = moc_get_cp_c(val);
+		switch (op) {
+			case MOC_EQ: return moc_eq_cstr(str);
+			case MOC_NE: return moc_ne_cstr(str);
+			case MOC_LT: return moc_lt_cstr(str);
+			case MOC_LE: return moc_le_cstr(str);
+			case MOC_GT: return moc_gt_cstr(str);
+			case MOC_GE: return moc_ge_cstr(str);
+		}
+	}
+	switch (op) {
+		case MOC_EQ: return moc_eq(val);
+		case MOC_NE: return moc_ne(val);
+		case MOC_LT: return moc_lt(val);
+		case MOC_LE: return moc_le(val);
+		case MOC_GT: return moc_gt(val);
+		case MOC_GE: return moc_ge(val);
+	}
+	return moc_any();
+}
+
+/* Adds a mapping returning the value, or adds the value to the sequence
+ * of the mapping node given, and returns the node of the mapping. */
+static struct moc_listnode *moc_cmdapply(const char *funcname,
+		struct moc_cmdmatchers *cm, struct moc_value retval,
+		struct moc_listnode *seqnode) {
+	struct moc_matcher matchers[MOC_AUXMAX];
+	struct moc_responder resp;
+	unsigned char i;
+	for (i = 0; i < cm->n; i++) {
+		matchers[i] = moc_cmdmatcher(cm->ops[i], cm->vals[i]);
+	}
+	resp = moc_return(retval);
+	return moc_given_nnn(funcname, cm->n, matchers, 0, matchers,
+			1, &resp, seqnode);
+}
+
+/* Writes the bytes to the compiled commands, remembering if full. */
+static void moc_cmdput(struct moc_cmdreader *rd, const void *bytes,
+		unsigned long n) {
+	if (! moc_recput(rd->out, &(rd->pos), bytes, n)) {
+		rd->full = moc_true;
+	}
+}
+
+static void moc_cmdputnum(struct moc_cmdreader *rd, unsigned long num,
+		unsigned int nbytes) {
+	if (! moc_recnum(rd->out, &(rd->pos), num, nbytes)) {
+		rd->full = moc_true;
+	}
+}
+
+/* Writes a string with its length and the ending NUL. */
+static void moc_cmdputstr(struct moc_cmdreader *rd, const char *str,
+		unsigned long len) {
+	if (len > 0xFFFF) {
+		rd->full = moc_true;
+		return;
+	}
+	moc_cmdputnum(rd, len, 2);
+	moc_cmdput(rd, str, len);
+	moc_cmdputnum(rd, 0, 1);
+}
+
+/* Writes a value, with the content of the strings. */
+static void moc_cmdputval(struct moc_cmdreader *rd, struct moc_value val) {
+	if (moc_isstrval(val)) {
+		moc_cmdputnum(rd, MOC_TRACESTR, 1);
+		moc_cmdputstr(rd, moc_get_cp_c(val),
+				moc_strlen(moc_get_cp_c(val)));
+	} else {
+		moc_cmdputnum(rd, MOC_TRACERAW, 1);
+		if (! moc_recval(rd->out, &(rd->pos), val)) {
+			rd->full = moc_true;
+		}
+	}
+}
+
+/* Checks the returned values of a given command without keeping them. */
+static moc_bool moc_cmdchkvals(struct moc_cmdreader *rd) {
+	struct moc_cmdreader saved;
+	struct moc_value val;
+	unsigned long storelen, nvals;
+	moc_bool ok;
+	saved = *rd;
+	storelen = moc_ctx.storelen;
+	ok = moc_cmdtok(rd);
+	for (nvals = 0; ok && rd->len > 0; nvals++) {
+		ok = nvals < 0xFF && moc_cmdval(rd->tok, rd->tok + rd->len,
+				&val);
+		if (ok) {
+			moc_cmdtok(rd);
+		}
+	}
+	moc_ctx.storelen = storelen;
+	if (! ok) {
+		return moc_cmderror(rd);
+	}
+	*rd = saved;
+	return moc_true;
+}
+
+/* Executes or compiles a given command after reading its first token. */
+static moc_bool moc_cmdgiven(struct moc_cmdreader *rd) {
+	struct moc_cmdmatchers cm;
+	struct moc_listnode *node;
+	struct moc_value retval;
+	const char *funcname;
+	unsigned long npos, nvals;
+	moc_bool isret;
+	if (! moc_cmdtok(rd) || moc_cmdis(rd, "returns")) {
+		return moc_cmderror(rd);
+	}
+	funcname = moc_cmdstore(rd->tok, rd->len, moc_false);
+	if (funcname == 0) {
+		return moc_false;
+	}
+	for (cm.n = 0; moc_cmdtok(rd) && ! moc_cmdis(rd, "returns"); cm.n++) {
+		if (cm.n == MOC_AUXMAX || ! moc_cmdmtc(rd, cm.ops + cm.n,
+				cm.vals + cm.n)) {
+			return moc_cmderror(rd);
+		}
+	}
+	if (rd->len > 0 && ! moc_cmdchkvals(rd)) {
+		return moc_false;
+	}
+	npos = 0;
+	if (rd->out != 0) {
+		moc_cmdputnum(rd, MOC_CMDGIVEN, 1);
+		moc_cmdputstr(rd, funcname, moc_strlen(funcname));
+		moc_cmdputnum(rd, cm.n, 1);
+		for (npos = 0; npos < cm.n; npos++) {
+			moc_cmdputnum(rd, cm.ops[npos], 1);
+			moc_cmdputval(rd, cm.vals[npos]);
+		}
+		npos = rd->pos;
+		moc_cmdputnum(rd, 0, 1);
+	}
+	/* Without values returns void, with many returns them in turn: */
+	node = MOC_NULLNODE;
+	isret = rd->len > 0;
+	if (! isret && rd->out == 0) {
+		node = moc_cmdapply(funcname, &cm, moc_emptyval, node);
+	}
+	for (nvals = 0; isret && moc_cmdtok(rd); nvals++) {
+		moc_cmdval(rd->tok, rd->tok + rd->len, &retval);
+		if (rd->out != 0) {
+			moc_cmdputval(rd, retval);
+		} else {
+			node = moc_cmdapply(funcname, &cm, retval, node);
+			if (node == MOC_NULLNODE) {
+				return moc_false;
+			}
+		}
+	}
+	if (rd->out != 0 && ! rd->full) {
+		rd->out->buf[npos] = (char) nvals;
+	}
+	return rd->out != 0 || node != MOC_NULLNODE;
+}
+
+/* Returns the position of the scenario with the given name or the
+ * number of scenarios if not found. */
+static unsigned int moc_findscenario(const char *name, unsigned long len) {
+	unsigned int i;
+	for (i = 0; i < moc_ctx.nscenarios; i++) {
+		if (moc_streqn(name, len, moc_ctx.scenarios[i].name)) {
+			break;
+		}
+	}
+	return i;
+}
+
+static void moc_runscenario(unsigned int i) {
+	moc_clear();
+	moc_ctx.scenarios[i].setup();
+}
+
+/* Executes or compiles a scenario command after reading its first
+ * token. The compiled scenarios are searched when they are loaded. */
+static moc_bool moc_cmdscenario(struct moc_cmdreader *rd) {
+	const char *name;
+	unsigned long len;
+	unsigned int i;
+	if (! moc_cmdtok(rd)) {
+		return moc_cmderror(rd);
+	}
+	name = rd->tok;
+	len = rd->len;
+	i = moc_findscenario(name, len);
+	if ((rd->out == 0 && i == moc_ctx.nscenarios) || moc_cmdtok(rd)) {
+		return moc_cmderror(rd);
+	}
+	if (rd->out != 0) {
+		moc_cmdputnum(rd, MOC_CMDSCENARIO, 1);
+		moc_cmdputstr(rd, name, len);
+	} else {
+		moc_runscenario(i);
+	}
+	return moc_true;
+}
+
+/* Executes or compiles all the commands, stopping at the first error. */
+static moc_bool moc_cmdrun(struct moc_cmdreader *rd, const char *cmds) {
+	unsigned long storelen;
+	moc_bool ok;
+	rd->p = cmds;
+	while (*rd->p != '\0') {
+		rd->cmd = rd->p;
+		rd->ntok = 0;
+		storelen = moc_ctx.storelen;
+		if (moc_cmdtok(rd)) {
+			if (moc_cmdis(rd, "given")) {
+				ok = moc_cmdgiven(rd);
+			} else if (moc_cmdis(rd, "reset")) {
+				ok = ! moc_cmdtok(rd) || moc_cmderror(rd);
+				if (ok && rd->out != 0) {
+					moc_cmdputnum(rd, MOC_CMDRESET, 1);
+				} else if (ok) {
+					moc_clear();
+				}
+			} else if (moc_cmdis(rd, "scenario")) {
+				ok = moc_cmdscenario(rd);
+			} else {
+				ok = moc_cmderror(rd);
+			}
+			if (rd->out != 0) {
+				moc_ctx.storelen = storelen;
+			}
+			if (! ok) {
+				return moc_false;
+			}
+		}
+		/* Skips the comments and the end of the command: */
+		while (*rd->p != '\0' && *rd->p != '\n' && *rd->p != ';') {
+			rd->p++;
+		}
+		if (*rd->p != '\0') {
+			rd->p++;
+		}
+	}
+	return moc_true;
+}
+
+moc_bool moc_command(const char *cmds) {
+	struct moc_cmdreader rd;
+	rd.out = 0;
+	rd.pos = 0;
+	rd.full = moc_false;
+	return moc_cmdrun(&rd, cmds);
+}
+
+unsigned long moc_command_hash(const char *cmds) {
+	return moc_fnv(MOC_FNVINIT, cmds, moc_strlen(cmds));
+}
+
+unsigned long moc_compile_commands(const char *cmds, char *buf,
+		unsigned long size) {
+	struct moc_recorder out;
+	struct moc_cmdreader rd;
+	moc_init_recorder(&out, buf, size);
+	rd.out = &out;
+	rd.pos = 0;
+	rd.full = moc_false;
+	moc_cmdput(&rd, MOC_CMDHDR, MOC_CMDHDRLEN);
+	moc_cmdputnum(&rd, moc_command_hash(cmds), 4);
+	if (! moc_cmdrun(&rd, cmds) || rd.full) {
+		return 0;
+	}
+	return rd.pos;
+}
+
+/* Returns the first copy of the string in the compiled commands. */
+static const char *moc_ldstr(const char *bin, const char *str) {
+	struct moc_strslot *slot;
+	unsigned long i;
+	slot = moc_strslot(str);
+	if (slot != 0 && slot->epoch != 0) {
+		return slot->str;
+	}
+	if (slot != 0) {
+		moc_strslotadd(slot, str, 0);
+		return str;
+	}
+	for (; bin < str; bin++) {
+		for (i = 0; bin[i] == str[i] && str[i] != '\0'; i++) {
+			;
+		}
+		if (bin[i] == str[i]) {
+			return bin;
+		}
+	}
+	return str;
+}
+
+/* Reads a value of the compiled commands, with the strings pointing to
+ * their first copy in them, so that their mappings can be merged. */
+static struct moc_value moc_rdcmdval(struct moc_reader *rd,
+		const char *bin) {
+	struct moc_value val;
+	const char *str;
+	if (moc_rdnum(rd, 1) == MOC_TRACESTR) {
+		str = moc_rdstr(rd, moc_rdnum(rd, 2));
+		return moc_cp_c(str == 0 ? str : moc_ldstr(bin, str));
+	}
+	val = moc_rdval(rd);
+	if (MOC_VALSTDTYPE(val) > MOC_FUN || MOC_VALPTRTYPE(val) > MOC_CPTR) {
+		rd->p = 0;
+		rd->left = 0;
+	}
+	return val;
+}
+
+/* Loads a compiled given command after its first byte, returning
+ * moc_false if it is invalid. The errors adding the mappings are
+ * reported by moc_given_nnn and remembered in failed. */
+static moc_bool moc_ldgiven(struct moc_reader *rd, const char *bin,
+		moc_bool *failed) {
+	struct moc_cmdmatchers cm;
+	struct moc_listnode *node;
+	struct moc_reader vals;
+	const char *funcname;
+	unsigned long nvals, i;
+	funcname = moc_rdstr(rd, moc_rdnum(rd, 2));
+	cm.n = (unsigned char) moc_rdnum(rd, 1);
+	if (cm.n > MOC_AUXMAX) {
+		return moc_false;
+	}
+	for (i = 0; i < cm.n; i++) {
+		cm.ops[i] = (unsigned char) moc_rdnum(rd, 1);
+		cm.vals[i] = moc_rdcmdval(rd, bin);
+		if (cm.ops[i] > MOC_GE && cm.ops[i] != MOC_CMDANY) {
+			return moc_false;
+		}
+	}
+	nvals = moc_rdnum(rd, 1);
+	vals = *rd;
+	for (i = 0; i < nvals; i++) {
+		moc_rdcmdval(rd, bin);
+	}
+	if (rd->p == 0) {
+		return moc_false;
+	}
+	node = MOC_NULLNODE;
+	for (i = 0; i < nvals || i == 0; i++) {
+		node = moc_cmdapply(funcname, &cm, nvals > 0
+				? moc_rdcmdval(&vals, bin) : moc_emptyval,
+				node);
+		if (node == MOC_NULLNODE) {
+			*failed = moc_true;
+			break;
+		}
+	}
+	return moc_true;
+}
+
+moc_bool moc_load_commands(const char *bin, unsigned long len,
+		unsigned long hash) {
+	struct moc_reader rd;
+	unsigned long op;
+	const char *name;
+	unsigned int i;
+	moc_bool ok, failed = moc_false;
+	rd.p = (const unsigned char *) bin;
+	rd.left = len;
+	name = (const char *) moc_rdbytes(&rd, MOC_CMDHDRLEN);
+	for (i = 0; name != 0 && i < MOC_CMDHDRLEN; i++) {
+		if (name[i] != MOC_CMDHDR[i]) {
+			return moc_false;
+		}
+	}
+	if (name == 0 || moc_rdnum(&rd, 4) != hash || rd.p == 0) {
+		return moc_false;
+	}
+	while (rd.left > 0) {
+		op = moc_rdnum(&rd, 1);
+		ok = moc_true;
+		if (op == MOC_CMDGIVEN) {
+			ok = moc_ldgiven(&rd, bin, &failed);
+		} else if (op == MOC_CMDRESET) {
+			moc_clear();
+		} else if (op == MOC_CMDSCENARIO) {
+			name = moc_rdstr(&rd, moc_rdnum(&rd, 2));
+			i = name == 0 ? 0 : moc_findscenario(name,
+					moc_strlen(name));
+			ok = name != 0 && i < moc_ctx.nscenarios;
+			if (ok) {
+				moc_runscenario(i);
+			}
+		} else {
+			ok = moc_false;
+		}
+		if (! ok || rd.p == 0) {
+			moc_send_error(MOC_ERR_INVALCMND, "compiled commands",
+					len - rd.left, 0, 0);
+			return moc_false;
+		}
+		if (failed) {
+			return moc_false;
+		}
+	}
+	return moc_true;
+}
+
+unsigned long moc_fingerprint(void) {
+	return moc_ctx.fingerprint.hi << 16 << 16 | moc_ctx.fingerprint.lo;
+}
+
+/* Moves the responders of each mapping to the order they were added. */
+static void moc_rewind(void) {
+	struct moc_list *lresps;
+	MOC_SIZE_T m;
+	for (m = 0; m < moc_ctx.nmaps; m++) {
+		lresps = &(moc_ctx.maps[m].lresps);
+		while (lresps->first != moc_ctx.maps[m].rfirst) {
+			moc_inslastlistnode(lresps,
+					moc_delfirstlistnode(lresps));
+		}
+	}
+}
+
+moc_bool moc_reuse(void (*setup)(void)) {
+	struct moc_fp fp;
+	fp = moc_ctx.fingerprint;
+	/* Only the mappings added by the same setup can be reused: */
+	if (setup == moc_ctx.reusefn && fp.hi == moc_ctx.reusefp.hi
+			&& fp.lo == moc_ctx.reusefp.lo) {
+		moc_fpinit(&(moc_ctx.fingerprint));
+		moc_ctx.dryrun = moc_true;
+		setup();
+		moc_ctx.dryrun = moc_false;
+		if (moc_ctx.fingerprint.hi == fp.hi
+				&& moc_ctx.fingerprint.lo == fp.lo) {
+			moc_rewind();
+			return moc_true;
+		}
+	}
+	moc_clear();
+	setup();
+	moc_ctx.reusefn = setup;
+	moc_ctx.reusefp = moc_ctx.fingerprint;
+	return moc_false;
+}
@@ -0,0 +1,43 @@
+/* Dispatch functions generated by moc_gen_aot() from a frozen Mocito configuration. */
+
+#include "mocito.h"
+
+struct moc_value moc_aot_seqfun(moc_type rettype,
+		struct moc_values_grp pgrp) {
+	static unsigned int seq[3];
+	static unsigned long epoch;
+	unsigned int i;
+	struct moc_value *p;
+	int t;
+	if (epoch != moc_epoch()) {
+		epoch = moc_epoch();
+		for (i = 0; i < 3; i++) {
+			seq[i] = 0;
+		}
+	}
+	p = pgrp.elems;
+	if (pgrp.nelems != 1 || rettype != 12) {
+		goto generic;
+	}
+	if ((t = (moc_get_type(p[0]) == 12))
+			&& moc_get_i(p[0]) == 1) {
+		switch (seq[0]) {
+		case 0: seq[0] = 1; return moc_i(10);
+		case 1: seq[0] = 2; return moc_i(11);
+		default: seq[0] = 0; return moc_i(12);
+		}
+	}
+	if (! t) {
+		goto generic;
+	}
+	if ((t = (moc_get_type(p[0]) == 12))
+			&& moc_get_i(p[0]) < 0) {
+		return moc_i((-0 - 1));
+	}
+	if (! t) {
+		goto generic;
+	}
+	return moc_i(0);
+generic:
+	return moc_act("seqfun", rettype, pgrp);
+}
@@ -0,0 +1,47 @@
+/* Mocks generated by mocgen. */
+
+#include "mocgen-sample.h"
+#include "mocito.h"
+
+struct smp_file *smp_open(const char *path, enum smp_mode mode) {
+	static struct moc_handle moc_hnd = MOC_HANDLE(smp_open);
+	return (struct smp_file *) moc_get_p(moc_act_h(&moc_hnd, MOC_TYPE_P,
+			moc_values_2(moc_cp_c(path), moc_i((int) mode))));
+}
+
+long smp_read(struct smp_file *file, char *buf, unsigned long size) {
+	static struct moc_handle moc_hnd = MOC_HANDLE(smp_read);
+	return moc_get_l(moc_act_h(&moc_hnd, MOC_TYPE_L,
+			moc_values_3(moc_p((void *) file), moc_p_c(buf),
+					moc_ul(size))));
+}
+
+void smp_close(struct smp_file *file) {
+	static struct moc_handle moc_hnd = MOC_HANDLE(smp_close);
+	moc_act_h(&moc_hnd, MOC_TYPE_VOID,
+			moc_values_1(moc_p((void *) file)));
+}
+
+double smp_scale(double value, float factor) {
+	static struct moc_handle moc_hnd = MOC_HANDLE(smp_scale);
+	return moc_get_d(moc_act_h(&moc_hnd, MOC_TYPE_D,
+			moc_values_2(moc_d(value), moc_f(factor))));
+}
+
+int smp_sum8(int a, int b, int c, int d, int e, int f, int g, int h) {
+	static struct moc_handle moc_hnd = MOC_HANDLE(smp_sum8);
+	struct moc_value moc_params[8];
+	moc_params[0] = moc_i(a);
+	moc_params[1] = moc_i(b);
+	moc_params[2] = moc_i(c);
+	moc_params[3] = moc_i(d);
+	moc_params[4] = moc_i(e);
+	moc_params[5] = moc_i(f);
+	moc_params[6] = moc_i(g);
+	moc_params[7] = moc_i(h);
+	return moc_get_i(moc_act_h(&moc_hnd, MOC_TYPE_I,
+			moc_init_values_grp(8, moc_params)));
+}
+
+/* Not supported: smp_printf */
+
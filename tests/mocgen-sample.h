@@ -0,0 +1,22 @@
+/*
+ * Sample header for the tests of the mocks generated by mocgen, which
+ * are written again in mocgen-sample.c from this directory with:
+ *
+ *   mocgen mocgen-sample.h > mocgen-sample.c
+ */
+
+#ifndef MOCGEN_SAMPLE_H
+#define MOCGEN_SAMPLE_H
+
+enum smp_mode { SMP_READ, SMP_WRITE };
+
+struct smp_file;
+
+struct smp_file *smp_open(const char *path, enum smp_mode mode);
+long smp_read(struct smp_file *file, char *buf, unsigned long size);
+void smp_close(struct smp_file *file);
+double smp_scale(double value, float factor);
+int smp_sum8(int a, int b, int c, int d, int e, int f, int g, int h);
+int smp_printf(const char *format, ...);
+
+#endif
@@ -0,0 +1,156 @@
+/*
+   Mocito is a mocking library for writing unit tests of C code.
+   Copyright (C) 2025 Carlos Rica Espinosa <jasampler@gmail.com>
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software Foundation,
+   Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+*/
+
+/*
+ * Tests of the generation of dispatch functions from a configuration.
+ *
+ * The dispatch functions of setup_sample() are compiled from the file
+ * aot-sample.c, which is written again running this test with -g.
+ */
+
+#include "mocito.h"
+#include <stdio.h>
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Create the default function to manage the mocking-related errors. */
+void moc_error(void) { fprintf(stderr, "%s\n", moc_errmsg()); exit(1); }
+
+void test_gen_aot(void) {
+	char mem[5000];
+	char code[3000];
+	unsigned long len;
+	int n;
+
+	moc_init(mem, sizeof(mem));
+	moc_given(MOC_FN(ifun2),
+			moc_match_2(moc_eq(moc_c('a')), moc_gt(moc_l(-5L))),
+			moc_respond_1(moc_return(moc_i(1))));
+	moc_given(MOC_FN(ifun2),
+			moc_match_2(moc_any(), moc_any_l()),
+			moc_respond_1(moc_return(moc_i(2))));
+	moc_given(MOC_FN(ifun2),
+			moc_match_2(moc_any(), moc_any_l()),
+			moc_respond_1(moc_return(moc_i(3))));
+	moc_given(MOC_FN(dfun1),
+			moc_match_1(moc_eq_cstr("x")),
+			moc_respond_1(moc_return(moc_d(-0.75))));
+	moc_given(MOC_FN(pfun1),
+			moc_match_1(moc_eq(moc_p(&n))),
+			moc_respond_1(moc_count(moc_p_i(&n))));
+
+	len = moc_gen_aot(code, sizeof(code));
+	assert(len == strlen(code));
+	assert(strstr(code, "struct moc_value moc_aot_ifun2(moc_type rettype,")
+			!= NULL);
+	assert(strstr(code, "moc_get_c(p[0]) == 97\n"
+			"\t\t\t&& (t = (moc_get_type(p[1]) == 16))\n"
+			"\t\t\t&& moc_get_l(p[1]) > (-5L)) {\n"
+			"\t\treturn moc_i(1);\n") != NULL);
+	assert(strstr(code, "moc_aot_strcmp(moc_get_cp_c(p[0]), \"x\") == 0")
+			!= NULL);
+	assert(strstr(code, "return moc_d((-(3.0) / 4.0));") != NULL);
+	assert(strstr(code, "return moc_act(\"dfun1\", rettype, pgrp);")
+			!= NULL);
+	assert(strstr(code, "/* Not specialized: pfun1 */") != NULL);
+
+	assert(moc_gen_aot(code, 10) == len);
+	assert(strlen(code) == 9);
+}
+
+void test_gen_aot_struct(void) {
+	char mem[5000];
+	char code[3000];
+	long st[2];
+
+	/* The matchers of structs use the generic dispatch: */
+	st[0] = 1;
+	st[1] = 2;
+	moc_init(mem, sizeof(mem));
+	moc_given(MOC_FN(sfun1), moc_match_1(moc_eq(MOC_ST(st, 7))),
+			moc_respond_1(moc_return(moc_i(1))));
+	moc_given(MOC_FN(sfun1), moc_match_1(moc_lt(MOC_ST(st, 7))),
+			moc_respond_1(moc_return(moc_i(2))));
+	moc_gen_aot(code, sizeof(code));
+	assert(strstr(code, "/* Not specialized: sfun1 */") != NULL);
+	assert(strstr(code, "moc_get_") == NULL);
+}
+
+static void setup_sample(void) {
+	moc_given(MOC_FN(seqfun), moc_match_1(moc_eq(moc_i(1))),
+			moc_respond_1(moc_return(moc_i(10))));
+	moc_given(MOC_FN(seqfun), moc_match_1(moc_eq(moc_i(1))),
+			moc_respond_1(moc_return(moc_i(11))));
+	moc_given(MOC_FN(seqfun), moc_match_1(moc_eq(moc_i(1))),
+			moc_respond_1(moc_return(moc_i(12))));
+	moc_given(MOC_FN(seqfun), moc_match_1(moc_lt(moc_i(0))),
+			moc_respond_1(moc_return(moc_i(-1))));
+	moc_given(MOC_FN(seqfun), moc_match_1(moc_any()),
+			moc_respond_1(moc_return(moc_i(0))));
+}
+
+#ifndef MOC_AOT_GEN
+#include "aot-sample.c"
+
+#define NSAMPLES 8
+
+static const int samples[NSAMPLES] = { 1, 1, 5, -3, 1, 1, 2, 1 };
+
+void test_aot_sample(void) {
+	char mem[5000];
+	int expected[NSAMPLES];
+	int i, run;
+	moc_init(mem, sizeof(mem));
+	setup_sample();
+	for (i = 0; i < NSAMPLES; i++) {
+		expected[i] = moc_get_i(moc_act(MOC_FN(seqfun), moc_type_i(),
+				moc_values_1(moc_i(samples[i]))));
+	}
+	assert(expected[0] == 10 && expected[1] == 11 && expected[4] == 12);
+	/* The results stay equal to moc_act after each moc_init: */
+	for (run = 0; run < 3; run++) {
+		moc_init(mem, sizeof(mem));
+		setup_sample();
+		for (i = 0; i < NSAMPLES; i++) {
+			assert(moc_get_i(moc_aot_seqfun(moc_type_i(),
+				moc_values_1(moc_i(samples[i]))))
+					== expected[i]);
+		}
+	}
+}
+#endif
+
+int main(int argc, char *argv[]) {
+	char mem[5000];
+	char code[3000];
+	if (argc > 1 && strcmp(argv[1], "-g") == 0) {
+		moc_init(mem, sizeof(mem));
+		setup_sample();
+		moc_gen_aot(code, sizeof(code));
+		fputs(code, stdout);
+		return 0;
+	}
+	test_gen_aot();
+	test_gen_aot_struct();
+#ifndef MOC_AOT_GEN
+	test_aot_sample();
+#endif
+	return 0;
+}
@@ -0,0 +1,110 @@
+/*
+   Mocito is a mocking library for writing unit tests of C code.
+   Copyright (C) 2025 Carlos Rica Espinosa <jasampler@gmail.com>
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software Foundation,
+   Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+*/
+
+
+/*
+ * Tests of the mocks with more than 7 parameters using caller arrays.
+ */
+
+#include "mocito.h"
+#include <stdio.h>
+#include <assert.h>
+#include <stdlib.h>
+
+/* Create the default function to manage the mocking-related errors. */
+void moc_error(void) { fprintf(stderr, "%s\n", moc_errmsg()); exit(1); }
+
+long draw_rect(int x, int y, int w, int h, int r, int g, int b,
+		int a, int border, int radius, const char *label, double zoom) {
+	struct moc_value params[12];
+	params[0] = moc_i(x);
+	params[1] = moc_i(y);
+	params[2] = moc_i(w);
+	params[3] = moc_i(h);
+	params[4] = moc_i(r);
+	params[5] = moc_i(g);
+	params[6] = moc_i(b);
+	params[7] = moc_i(a);
+	params[8] = moc_i(border);
+	params[9] = moc_i(radius);
+	params[10] = moc_cp_c(label);
+	params[11] = moc_d(zoom);
+	return moc_get_l(moc_act_v(MOC_FN(draw_rect), moc_type_l(),
+			12, params));
+}
+
+static int nerrors;
+
+static void count_error(void) {
+	nerrors++;
+}
+
+void test_arity(void) {
+	char mem[4000];
+	struct moc_matcher matchers[12];
+	struct moc_responder responders[2];
+	int i, ncalls = 0;
+	moc_init(mem, sizeof(mem));
+	for (i = 0; i < 12; i++) {
+		matchers[i] = moc_any();
+	}
+	matchers[9] = moc_eq(moc_i(4));
+	responders[0] = moc_count(moc_p_i(&ncalls));
+	responders[1] = moc_return(moc_l(40));
+	moc_given_v(MOC_FN(draw_rect), 12, matchers, 2, responders);
+	/* The arrays can be reused after adding the mapping: */
+	matchers[9] = moc_any();
+	matchers[11] = moc_gt(moc_d(1.0));
+	responders[1] = moc_return(moc_l(2));
+	moc_given_v(MOC_FN(draw_rect), 12, matchers, 2, responders);
+	assert(draw_rect(0, 0, 10, 10, 255, 0, 0, 255, 1, 4, "ok", 1.0)
+			== 40);
+	assert(draw_rect(0, 0, 10, 10, 255, 0, 0, 255, 1, 0, "ok", 2.0)
+			== 2);
+	assert(ncalls == 2);
+}
+
+void test_maxparams(void) {
+	char mem[4000];
+	struct moc_value params[MOC_MAXPARAMS + 1];
+	struct moc_matcher matchers[MOC_MAXPARAMS + 1];
+	struct moc_responder responders[1];
+	moc_errfn_t errfn;
+	int i;
+	moc_init(mem, sizeof(mem));
+	for (i = 0; i <= MOC_MAXPARAMS; i++) {
+		params[i] = moc_i(i);
+		matchers[i] = moc_any();
+	}
+	responders[0] = moc_return(moc_i(1));
+	errfn = moc_get_errfn();
+	moc_set_errfn(count_error);
+	nerrors = 0;
+	moc_given_v("many", MOC_MAXPARAMS + 1, matchers, 1, responders);
+	assert(nerrors == 1);
+	moc_act_v("many", moc_type_i(), MOC_MAXPARAMS + 1, params);
+	assert(nerrors == 2);
+	moc_set_errfn(errfn);
+}
+
+int main(void) {
+	test_arity();
+	test_maxparams();
+	return 0;
+}
@@ -0,0 +1,179 @@
+/*
+   Mocito is a mocking library for writing unit tests of C code.
+   Copyright (C) 2025 Carlos Rica Espinosa <jasampler@gmail.com>
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software Foundation,
+   Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+*/
+
+
+/*
+ * Tests of the mappings selected by the region of the caller.
+ */
+
+#include "mocito.h"
+#include <stdio.h>
+#include <assert.h>
+#include <stdlib.h>
+
+/* Create the default function to manage the mocking-related errors. */
+void moc_error(void) { fprintf(stderr, "%s\n", moc_errmsg()); exit(1); }
+
+#ifdef __GNUC__
+#define NOINLINE __attribute__((noinline))
+#else
+#define NOINLINE
+#endif
+
+#define HOT 1
+#define COLD 2
+
+static const void *last_caller;
+
+NOINLINE int lookup(int key) {
+	last_caller = MOC_CALLER();
+	moc_set_caller(last_caller);
+	return moc_get_i(moc_act(MOC_FN(lookup), moc_type_i(),
+			moc_values_1(moc_i(key))));
+}
+
+/* A mock that does not set its caller: */
+NOINLINE int plain(int key) {
+	return moc_get_i(moc_act(MOC_FN(plain), moc_type_i(),
+			moc_values_1(moc_i(key))));
+}
+
+NOINLINE int hot_path(int key) {
+	return lookup(key) + 1;
+}
+
+NOINLINE int cold_path(int key) {
+	return lookup(key) + 2;
+}
+
+/* Called through pointers so the compiler keeps the functions: */
+int (*volatile hot_fn)(int) = hot_path;
+int (*volatile cold_fn)(int) = cold_path;
+
+union address {
+	int (*fn)(int);
+	const void *ptr;
+};
+
+/* Sets the region of a function until the return from the mock. */
+static void init_region(struct moc_region *region, int (*fn)(int),
+		int id) {
+	union address addr;
+	char mem[1000];
+	addr.fn = fn;
+	moc_init(mem, sizeof(mem));
+	moc_given(MOC_FN(lookup), moc_match_1(moc_any()),
+			moc_respond_1(moc_return(moc_i(0))));
+	fn(0);
+	region->start = addr.ptr;
+	region->end = (const char *) last_caller + 1;
+	region->id = id;
+}
+
+void test_caller(void) {
+	char mem[2000];
+	struct moc_region regions[2], tmp;
+	if (MOC_CALLER() == 0) {
+		return; /* not supported by the compiler */
+	}
+	init_region(regions, hot_fn, HOT);
+	init_region(regions + 1, cold_fn, COLD);
+	if ((const char *) regions[1].start
+			< (const char *) regions[0].start) {
+		tmp = regions[0];
+		regions[0] = regions[1];
+		regions[1] = tmp;
+	}
+	moc_init(mem, sizeof(mem));
+	moc_set_regions(regions, 2);
+	moc_given_extra(MOC_FN(lookup), moc_match_1(moc_any()),
+			moc_xmatch_1(moc_caller(HOT)),
+			moc_respond_1(moc_return(moc_i(10))));
+	moc_given_extra(MOC_FN(lookup), moc_match_1(moc_any()),
+			moc_xmatch_1(moc_caller(COLD)),
+			moc_respond_1(moc_return(moc_i(20))));
+	moc_given(MOC_FN(lookup), moc_match_1(moc_any()),
+			moc_respond_1(moc_return(moc_i(30))));
+	assert(hot_fn(1) == 11);
+	assert(cold_fn(1) == 22);
+	assert(hot_fn(2) == 11);
+	assert(lookup(1) == 30);
+}
+
+void test_caller_forgotten(void) {
+	char mem[2000];
+	struct moc_region region;
+	if (MOC_CALLER() == 0) {
+		return;
+	}
+	init_region(&region, hot_fn, HOT);
+	moc_init(mem, sizeof(mem));
+	moc_set_regions(&region, 1);
+	moc_given_extra(MOC_FN(plain), moc_match_1(moc_any()),
+			moc_xmatch_1(moc_caller(HOT)),
+			moc_respond_1(moc_return(moc_i(10))));
+	moc_given(MOC_FN(plain), moc_match_1(moc_any()),
+			moc_respond_1(moc_return(moc_i(30))));
+	moc_given(MOC_FN(lookup), moc_match_1(moc_any()),
+			moc_respond_1(moc_return(moc_i(0))));
+	assert(hot_fn(1) == 1);
+	assert(plain(1) == 30);
+}
+
+static int nested;
+
+/* Matcher calling another mock that does not set its caller: */
+static moc_bool call_plain(struct moc_call *call, struct moc_value val) {
+	if (sizeof(call)) {} /* unused warning */
+	nested = plain(moc_get_i(val));
+	return moc_true;
+}
+
+void test_caller_nested(void) {
+	char mem[2000];
+	struct moc_region region;
+	if (MOC_CALLER() == 0) {
+		return;
+	}
+	init_region(&region, hot_fn, HOT);
+	moc_init(mem, sizeof(mem));
+	moc_set_regions(&region, 1);
+	moc_given_extra(MOC_FN(plain), moc_match_1(moc_any()),
+			moc_xmatch_1(moc_caller(HOT)),
+			moc_respond_1(moc_return(moc_i(10))));
+	moc_given(MOC_FN(plain), moc_match_1(moc_any()),
+			moc_respond_1(moc_return(moc_i(30))));
+	/* The outer call keeps its caller after the nested call: */
+	moc_given_extra(MOC_FN(lookup), moc_match_1(moc_any()),
+			moc_xmatch_2(moc_xcall(&call_plain, moc_i(1)),
+				moc_caller(HOT)),
+			moc_respond_1(moc_return(moc_i(10))));
+	moc_given(MOC_FN(lookup), moc_match_1(moc_any()),
+			moc_respond_1(moc_return(moc_i(0))));
+	nested = 0;
+	assert(hot_fn(1) == 11);
+	assert(nested == 30);
+}
+
+int main(void) {
+	test_caller();
+	test_caller_forgotten();
+	test_caller_nested();
+	return 0;
+}
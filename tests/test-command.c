@@ -0,0 +1,278 @@
+/*
+   Mocito is a mocking library for writing unit tests of C code.
+   Copyright (C) 2025 Carlos Rica Espinosa <jasampler@gmail.com>
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software Foundation,
+   Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+*/
+
+
+/*
+ * Tests of the configuration of mocks with text commands.
+ */
+
+#include "mocito.h"
+#include <stdio.h>
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Create the default function to manage the mocking-related errors. */
+void moc_error(void) { fprintf(stderr, "%s\n", moc_errmsg()); exit(1); }
+
+static int nerrors;
+
+void count_error(void) {
+	nerrors++;
+}
+
+int open_file(const char *path, int flags) {
+	return moc_get_i(moc_act(MOC_FN(open_file), moc_type_i(),
+			moc_values_2(moc_cp_c(path), moc_i(flags))));
+}
+
+double scale(double x, unsigned char n) {
+	return moc_get_d(moc_act(MOC_FN(scale), moc_type_d(),
+			moc_values_2(moc_d(x), moc_uc(n))));
+}
+
+void close_file(int fd) {
+	moc_act(MOC_FN(close_file), moc_type_void(), moc_values_1(moc_i(fd)));
+}
+
+long get_size(long size) {
+	return moc_get_l(moc_act(MOC_FN(get_size), moc_type_l(),
+			moc_values_1(moc_l(size))));
+}
+
+void setup_failing(void) {
+	moc_command("given open_file any any returns -1");
+}
+
+void setup_working(void) {
+	moc_command("given open_file \"a.txt\" any returns 3;"
+			"given open_file any any returns 4");
+}
+
+static const struct moc_scenario scenarios[] = {
+	{ "failing", setup_failing },
+	{ "working", setup_working }
+};
+
+void test_command_given(void) {
+	char mem[3000], store[200];
+	moc_init(mem, sizeof(mem));
+	moc_init_store(store, sizeof(store));
+	assert(moc_command("given open_file \"a\\\"b\" 2 returns 7\n"
+			"given open_file !=\"a.txt\" any returns 5 # comment\n"
+			"\n"
+			"given scale >=1.5 (unsigned char)3 returns -2.5e1\n"
+			"given scale <1.5 any returns 16.0 ; "
+			"given get_size 8L returns 1L"));
+	assert(open_file("a\"b", 2) == 7);
+	assert(open_file("b", 1) == 5);
+	assert(scale(2.0, 3) == -25.0);
+	assert(scale(1.0, 9) == 16);
+	assert(get_size(8) == 1);
+	assert(moc_command("reset; given open_file any any returns 'x'"));
+	assert(open_file("a\"b", 2) == 'x');
+}
+
+void test_command_scenario(void) {
+	char mem[3000], store[200];
+	moc_init(mem, sizeof(mem));
+	moc_init_store(store, sizeof(store));
+	moc_set_scenarios(scenarios, 2);
+	assert(moc_command("scenario working"));
+	assert(open_file("a.txt", 0) == 3);
+	assert(open_file("b.txt", 0) == 4);
+	assert(moc_command("scenario failing"));
+	assert(open_file("a.txt", 0) == -1);
+}
+
+void test_command_errors(void) {
+	char mem[3000], store[20];
+	moc_errfn_t errfn;
+	moc_init(mem, sizeof(mem));
+	moc_init_store(store, sizeof(store));
+	errfn = moc_get_errfn();
+	moc_set_errfn(count_error);
+	nerrors = 0;
+	assert(! moc_command("given f 1 returns"));
+	assert(nerrors == 1);
+	assert(strstr(moc_errmsg(), "invalid command") != NULL);
+	assert(! moc_command("scenario unknown"));
+	assert(! moc_command("given f (long double)1"));
+	assert(! moc_command("given f 1.5U"));
+	assert(! moc_command("remove f"));
+	assert(nerrors == 5);
+	assert(! moc_command("given a_very_long_function_name any"));
+	assert(nerrors == 6);
+	moc_set_errfn(errfn);
+	assert(moc_command("  # only a comment\n;;"));
+}
+
+void test_command_sequence(void) {
+	char mem[3000], store[100];
+	moc_init(mem, sizeof(mem));
+	moc_init_store(store, sizeof(store));
+	assert(moc_command("given get_size any returns 1L 2L 3L\n"
+			"given open_file \"a\" 1 returns 5; given open_file "
+			"\"a\" 1 returns 6 7"));
+	assert(get_size(0) == 1);
+	assert(get_size(0) == 2);
+	assert(get_size(0) == 3);
+	assert(get_size(0) == 1);
+	assert(open_file("a", 1) == 5);
+	assert(open_file("a", 1) == 6);
+	assert(open_file("a", 1) == 7);
+	assert(open_file("a", 1) == 5);
+}
+
+void test_command_compiled(void) {
+	const char *cmds;
+	char mem[3000], store[100], bin[300];
+	unsigned long len, hash;
+	moc_errfn_t errfn;
+	moc_init(mem, sizeof(mem));
+	moc_init_store(store, sizeof(store));
+	moc_set_scenarios(scenarios, 2);
+	cmds = "given open_file \"c\" 2 returns 1; given open_file \"c\" 2 "
+		"returns 2\n"
+		"given open_file !=\"c\" any returns 8 9\n"
+		"given get_size >2L returns 4L\n"
+		"given close_file any";
+	hash = moc_command_hash(cmds);
+	assert(hash == moc_command_hash(cmds));
+	assert(hash != moc_command_hash("reset"));
+	assert(moc_compile_commands(cmds, bin, 20) == 0);
+	len = moc_compile_commands(cmds, bin, sizeof(bin));
+	assert(len > 0);
+	memset(store, 0, sizeof(store));
+	assert(! moc_load_commands(bin, len, hash + 1));
+	assert(moc_load_commands(bin, len, hash));
+	assert(open_file("a", 0) == 8);
+	assert(open_file("b", 0) == 9);
+	assert(open_file("c", 2) == 1);
+	assert(open_file("c", 2) == 2);
+	assert(get_size(3) == 4);
+	close_file(1);
+	hash = moc_command_hash("scenario failing");
+	len = moc_compile_commands("scenario failing", bin, sizeof(bin));
+	assert(moc_load_commands(bin, len, hash));
+	assert(open_file("a", 0) == -1);
+	moc_init(mem, sizeof(mem));
+	errfn = moc_get_errfn();
+	moc_set_errfn(count_error);
+	nerrors = 0;
+	assert(! moc_load_commands(bin, len - 1, hash));
+	assert(nerrors == 1);
+	moc_set_errfn(errfn);
+}
+
+/* Checks that the mappings of the many equal strings were merged. */
+static void check_many(int n) {
+	char path[16];
+	int i;
+	for (i = 0; i < n; i++) {
+		sprintf(path, "f%d", i);
+		assert(open_file(path, 1) == i);
+		assert(open_file(path, 1) == i + 1000);
+	}
+}
+
+void test_command_many_strings(void) {
+	static char mem[200000], store[2000], cmds[20000], bin[20000];
+	unsigned long len, hash, n;
+	int i, k;
+	/* More different strings than the table of strings: */
+	n = 0;
+	for (k = 0; k < 2; k++) {
+		for (i = 0; i < 200; i++) {
+			n += sprintf(cmds + n, "given open_file \"f%d\" 1 "
+					"returns %d\n", i, i + k * 1000);
+		}
+	}
+	moc_init(mem, sizeof(mem));
+	moc_init_store(store, sizeof(store));
+	assert(moc_command(cmds));
+	check_many(200);
+
+	moc_init(mem, sizeof(mem));
+	moc_init_store(store, sizeof(store));
+	hash = moc_command_hash(cmds);
+	len = moc_compile_commands(cmds, bin, sizeof(bin));
+	assert(len > 0);
+	assert(moc_load_commands(bin, len, hash));
+	check_many(200);
+}
+
+static int npolls;
+
+void poll_commands(void) {
+	if (npolls++ == 0) {
+		moc_command("given get_size any returns 9L");
+	}
+}
+
+void test_command_poll(void) {
+	char mem[3000], store[100];
+	moc_init(mem, sizeof(mem));
+	moc_init_store(store, sizeof(store));
+	npolls = 0;
+	moc_set_pollfn(poll_commands);
+	assert(get_size(1) == 9);
+	assert(get_size(2) == 9);
+	assert(npolls == 2);
+	moc_set_pollfn(NULL);
+}
+
+/* Responder calling again to the mock with the size decremented. */
+struct moc_value call_size(struct moc_call *call, struct moc_value data) {
+	if (sizeof(data)) {} /* unused warning */
+	return moc_l(1 + get_size(moc_get_l(call->params[0]) - 1));
+}
+
+void count_polls(void) {
+	npolls++;
+}
+
+void test_command_poll_nested(void) {
+	char mem[3000];
+	moc_init(mem, sizeof(mem));
+	moc_given(MOC_FN(get_size), moc_match_1(moc_eq(moc_l(0))),
+			moc_respond_1(moc_return(moc_l(0))));
+	moc_given(MOC_FN(get_size), moc_match_1(moc_gt(moc_l(0))),
+			moc_respond_1(moc_rcall(&call_size, moc_l(0))));
+	npolls = 0;
+	moc_set_pollfn(count_polls);
+	/* The nested calls do not poll: */
+	assert(get_size(3) == 3);
+	assert(npolls == 1);
+	assert(get_size(2) == 2);
+	assert(npolls == 2);
+	moc_set_pollfn(NULL);
+}
+
+int main(void) {
+	test_command_given();
+	test_command_scenario();
+	test_command_errors();
+	test_command_sequence();
+	test_command_compiled();
+	test_command_many_strings();
+	test_command_poll();
+	test_command_poll_nested();
+	return 0;
+}
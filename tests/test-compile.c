@@ -0,0 +1,110 @@
+/*
+   Mocito is a mocking library for writing unit tests of C code.
+   Copyright (C) 2025 Carlos Rica Espinosa <jasampler@gmail.com>
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software Foundation,
+   Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+*/
+
+/*
+ * Tests of mocks with compiled matchers.
+ */
+
+#include "mocito.h"
+#include <stdio.h>
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Create the default function to manage the mocking-related errors. */
+void moc_error(void) { fprintf(stderr, "%s\n", moc_errmsg()); exit(1); }
+
+int ifun2(char c, long l) {
+	return moc_get_i(moc_act(MOC_FN(ifun2), moc_type_i(),
+			moc_values_2(moc_c(c), moc_l(l))));
+}
+
+const char *strfun2(const char *str, double d) {
+	return moc_get_cp_c(moc_act(MOC_FN(strfun2), moc_type_cp_c(),
+			moc_values_2(moc_cp_c(str), moc_d(d))));
+}
+
+static void given_mappings(void) {
+	moc_given(MOC_FN(ifun2),
+			moc_match_2(moc_eq(moc_c('a')), moc_lt(moc_l(0L))),
+			moc_respond_1(moc_return(moc_i(1))));
+	moc_given(MOC_FN(ifun2),
+			moc_match_2(moc_ne(moc_c('a')), moc_ge(moc_l(100L))),
+			moc_respond_1(moc_return(moc_i(2))));
+	moc_given(MOC_FN(ifun2),
+			moc_match_2(moc_any_c(), moc_any()),
+			moc_respond_1(moc_return(moc_i(3))));
+	moc_given(MOC_FN(strfun2),
+			moc_match_2(moc_eq_cstr("x"), moc_gt(moc_d(1.5))),
+			moc_respond_1(moc_return(moc_cp_c("big"))));
+	moc_given(MOC_FN(strfun2),
+			moc_match_2(moc_any_cp_c(), moc_le(moc_d(1.5))),
+			moc_respond_1(moc_return(moc_cp_c("small"))));
+}
+
+static void check_results(void) {
+	assert(1 == ifun2('a', -1L));
+	assert(3 == ifun2('a', 100L));
+	assert(2 == ifun2('b', 100L));
+	assert(3 == ifun2('b', 99L));
+	assert(strcmp(strfun2("x", 2.0), "big") == 0);
+	assert(strcmp(strfun2("y", 1.5), "small") == 0);
+	assert(strcmp(strfun2("x", 1.0), "small") == 0);
+}
+
+void test_compile(void) {
+	char mem[4000];
+
+	moc_init(mem, sizeof(mem));
+	given_mappings();
+	check_results();
+
+	moc_init(mem, sizeof(mem));
+	given_mappings();
+	moc_compile(MOC_FN(ifun2));
+	moc_compile(MOC_FN(strfun2));
+	moc_compile(MOC_FN(unknown));
+	check_results();
+}
+
+void test_compile_given(void) {
+	char mem[4000];
+
+	moc_init(mem, sizeof(mem));
+	given_mappings();
+	moc_compile(MOC_FN(ifun2));
+	assert(2 == ifun2('b', 100L));
+	moc_given(MOC_FN(ifun2),
+			moc_match_2(moc_eq(moc_c('b')), moc_eq(moc_l(100L))),
+			moc_respond_1(moc_return(moc_i(4))));
+	assert(2 == ifun2('b', 100L));
+	moc_given(MOC_FN(ifun2),
+			moc_match_2(moc_ne(moc_c('a')), moc_ge(moc_l(100L))),
+			moc_respond_1(moc_return(moc_i(5))));
+	moc_compile(MOC_FN(ifun2));
+	assert(2 == ifun2('b', 100L));
+	assert(5 == ifun2('b', 100L));
+	assert(1 == ifun2('a', -1L));
+}
+
+int main(void) {
+	test_compile();
+	test_compile_given();
+	return 0;
+}
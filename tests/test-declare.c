@@ -0,0 +1,171 @@
+/*
+   Mocito is a mocking library for writing unit tests of C code.
+   Copyright (C) 2025 Carlos Rica Espinosa <jasampler@gmail.com>
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software Foundation,
+   Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+*/
+
+
+/*
+ * Tests of the declared signatures of the mocked functions.
+ */
+
+#include "mocito.h"
+#include <stdio.h>
+#include <assert.h>
+#include <stdlib.h>
+
+/* Create the default function to manage the mocking-related errors. */
+void moc_error(void) { fprintf(stderr, "%s\n", moc_errmsg()); exit(1); }
+
+static const moc_type scale_types[] = { MOC_TYPE_I, MOC_TYPE_D };
+
+long scale(int n, double factor) {
+	static struct moc_handle moc_hnd = MOC_HANDLE(scale);
+	return moc_get_l(moc_act_h(&moc_hnd, moc_type_l(),
+			moc_values_2(moc_i(n), moc_d(factor))));
+}
+
+static moc_bool is_positive(struct moc_value param,
+		struct moc_value value) {
+	if (sizeof(value)) {} /* unused warning */
+	return moc_get_d(param) > 0.0 ? moc_true : moc_false;
+}
+
+static int nerrors;
+
+static void count_error(void) {
+	nerrors++;
+}
+
+void test_declare(void) {
+	char mem[2000];
+	moc_errfn_t errfn;
+	moc_init(mem, sizeof(mem));
+	assert(moc_declare(MOC_FN(scale), MOC_TYPE_L, 2, scale_types));
+	moc_given(MOC_FN(scale), moc_match_2(moc_eq(moc_i(2)), moc_any()),
+			moc_respond_1(moc_return(moc_l(20))));
+	moc_given(MOC_FN(scale), moc_match_2(moc_any(), moc_lt(moc_d(0.0))),
+			moc_respond_1(moc_return(moc_l(-1))));
+	assert(scale(2, 1.5) == 20);
+	assert(scale(3, -1.0) == -1);
+
+	/* The mappings with wrong types are rejected when added: */
+	errfn = moc_get_errfn();
+	moc_set_errfn(count_error);
+	nerrors = 0;
+	moc_given(MOC_FN(scale), moc_match_2(moc_eq(moc_l(2)), moc_any()),
+			moc_respond_1(moc_return(moc_l(0))));
+	assert(nerrors == 1 && ! moc_err_nomatch());
+	moc_given(MOC_FN(scale), moc_match_2(moc_any(), moc_any()),
+			moc_respond_1(moc_return(moc_i(0))));
+	assert(nerrors == 2);
+	moc_given_extra(MOC_FN(scale), moc_match_2(moc_any(), moc_any()),
+			moc_xmatch_1(moc_xparam(2, &is_positive, moc_i(0))),
+			moc_respond_1(moc_return(moc_l(0))));
+	assert(nerrors == 3);
+	assert(scale(3, 1.0) == 0 && nerrors == 4); /* no mapping */
+	assert(moc_err_nomatch());
+	moc_set_errfn(errfn);
+}
+
+void test_declare_after(void) {
+	char mem[2000];
+	moc_errfn_t errfn;
+	moc_init(mem, sizeof(mem));
+	moc_given(MOC_FN(scale), moc_match_2(moc_eq(moc_l(2)), moc_any()),
+			moc_respond_1(moc_return(moc_l(20))));
+	errfn = moc_get_errfn();
+	moc_set_errfn(count_error);
+	nerrors = 0;
+	assert(! moc_declare(MOC_FN(scale), MOC_TYPE_L, 2, scale_types));
+	assert(nerrors == 1);
+	moc_set_errfn(errfn);
+	moc_init(mem, sizeof(mem));
+	moc_given(MOC_FN(scale), moc_match_2(moc_eq(moc_i(2)), moc_any()),
+			moc_respond_1(moc_return(moc_l(20))));
+	assert(moc_declare(MOC_FN(scale), MOC_TYPE_L, 2, scale_types));
+	assert(scale(2, 0.5) == 20);
+}
+
+void test_declare_mappings(void) {
+	char mem[2000];
+	struct moc_handle hnd = MOC_HANDLE(scale);
+	moc_init(mem, sizeof(mem));
+	assert(moc_declare(MOC_FN(scale), MOC_TYPE_L, 2, scale_types));
+	/* A declared function has no mappings until they are added: */
+	assert(! moc_has_mappings(&hnd, 2));
+	moc_given(MOC_FN(scale), moc_match_2(moc_any(), moc_any()),
+			moc_respond_1(moc_return(moc_l(7))));
+	assert(moc_has_mappings(&hnd, 2));
+	assert(scale(1, 1.0) == 7);
+}
+
+void setup_scale(void) {
+	moc_declare(MOC_FN(scale), MOC_TYPE_L, 2, scale_types);
+	moc_given(MOC_FN(scale), moc_match_2(moc_any(), moc_any()),
+			moc_respond_1(moc_return(moc_l(5))));
+}
+
+void test_declare_reuse(void) {
+	char mem[2000];
+	moc_init(mem, sizeof(mem));
+	assert(! moc_reuse(setup_scale));
+	assert(moc_reuse(setup_scale));
+	assert(scale(1, 1.0) == 5);
+}
+
+static struct moc_value return_int(struct moc_call *call,
+		struct moc_value data) {
+	if (sizeof(call)) {} /* unused warning */
+	return moc_i(moc_get_i(data));
+}
+
+void test_trusted(void) {
+	char mem[2000];
+	moc_errfn_t errfn;
+	int i;
+	long sum = 0;
+	moc_init(mem, sizeof(mem));
+	moc_declare(MOC_FN(scale), MOC_TYPE_L, 2, scale_types);
+	moc_given(MOC_FN(scale), moc_match_2(moc_lt(moc_i(0)), moc_any()),
+			moc_respond_1(moc_rcall(&return_int, moc_i(0))));
+	moc_given(MOC_FN(scale), moc_match_2(moc_any(), moc_any()),
+			moc_respond_1(moc_return(moc_l(3))));
+	moc_set_trusted(moc_true);
+	for (i = 0; i < 1000; i++) {
+		sum += scale(i, 0.5);
+	}
+	assert(sum == 3000);
+	/* The returned values are not checked in trusted mode: */
+	errfn = moc_get_errfn();
+	moc_set_errfn(count_error);
+	nerrors = 0;
+	scale(-1, 0.5);
+	assert(nerrors == 0);
+	moc_set_trusted(moc_false);
+	scale(-1, 0.5);
+	assert(nerrors == 1);
+	moc_set_errfn(errfn);
+}
+
+int main(void) {
+	test_declare();
+	test_declare_after();
+	test_declare_mappings();
+	test_declare_reuse();
+	test_trusted();
+	return 0;
+}
@@ -0,0 +1,123 @@
+/*
+   Mocito is a mocking library for writing unit tests of C code.
+   Copyright (C) 2025 Carlos Rica Espinosa <jasampler@gmail.com>
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software Foundation,
+   Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+*/
+
+
+/*
+ * Tests of the state machines responding to the calls of a protocol.
+ */
+
+#include "mocito.h"
+#include <stdio.h>
+#include <assert.h>
+#include <stdlib.h>
+
+/* Create the default function to manage the mocking-related errors. */
+void moc_error(void) { fprintf(stderr, "%s\n", moc_errmsg()); exit(1); }
+
+int srv_open(int port) {
+	return moc_get_i(moc_act(MOC_FN(srv_open), moc_type_i(),
+			moc_values_1(moc_i(port))));
+}
+
+int srv_send(const char *msg) {
+	return moc_get_i(moc_act(MOC_FN(srv_send), moc_type_i(),
+			moc_values_1(moc_cp_c(msg))));
+}
+
+int srv_close(void) {
+	return moc_get_i(moc_act(MOC_FN(srv_close), moc_type_i(),
+			moc_values_0()));
+}
+
+enum { CLOSED, OPEN, READY };
+
+static const struct moc_transition protocol[] = {
+	MOC_TRANSITION(CLOSED, srv_open, MOC_TEQ_I(80), MOC_TRET_I(0), OPEN),
+	MOC_TRANSITION(CLOSED, srv_open, MOC_TANY, MOC_TRET_I(-1), CLOSED),
+	MOC_TRANSITION(OPEN, srv_send, MOC_TEQ_CSTR("HELO"), MOC_TRET_I(250),
+			READY),
+	MOC_TRANSITION(OPEN, srv_close, MOC_TANY, MOC_TRET_I(0), CLOSED),
+	MOC_TRANSITION(READY, srv_send, MOC_TEQ_CSTR("QUIT"), MOC_TRET_I(221),
+			OPEN),
+	MOC_TRANSITION(READY, srv_send, MOC_TANY, MOC_TRET_I(200), READY)
+};
+
+static int nerrors;
+
+static void count_error(void) {
+	nerrors++;
+}
+
+void test_fsm(void) {
+	char mem[2000];
+	struct moc_fsm fsm;
+	moc_errfn_t errfn;
+	moc_init(mem, sizeof(mem));
+	assert(moc_init_fsm(&fsm, protocol,
+			sizeof(protocol) / sizeof(protocol[0]), CLOSED));
+	moc_given(MOC_FN(srv_open), moc_match_1(moc_any()),
+			moc_respond_1(moc_transit(&fsm)));
+	moc_given(MOC_FN(srv_send), moc_match_1(moc_any()),
+			moc_respond_1(moc_transit(&fsm)));
+	moc_given(MOC_FN(srv_close), moc_match_0(),
+			moc_respond_1(moc_transit(&fsm)));
+	assert(srv_open(81) == -1);
+	assert(moc_fsm_state(&fsm) == CLOSED);
+	assert(srv_open(80) == 0);
+	assert(moc_fsm_state(&fsm) == OPEN);
+	assert(srv_send("HELO") == 250);
+	assert(srv_send("GET a") == 200);
+	assert(srv_send("GET b") == 200);
+	assert(moc_fsm_state(&fsm) == READY);
+	assert(srv_send("QUIT") == 221);
+	assert(srv_close() == 0);
+	assert(moc_fsm_state(&fsm) == CLOSED);
+
+	/* The calls without transitions in the state are errors,
+	 * also reported for the type of the empty value returned: */
+	errfn = moc_get_errfn();
+	moc_set_errfn(count_error);
+	nerrors = 0;
+	srv_send("GET c");
+	assert(nerrors == 2);
+	assert(moc_fsm_state(&fsm) == CLOSED);
+	moc_set_errfn(errfn);
+}
+
+void test_fsm_invalid(void) {
+	static const struct moc_transition unsorted[] = {
+		MOC_TRANSITION(1, srv_close, MOC_TANY, MOC_TRET_I(0), 0),
+		MOC_TRANSITION(0, srv_open, MOC_TANY, MOC_TRET_I(0), 1)
+	};
+	struct moc_fsm fsm;
+	moc_errfn_t errfn;
+	errfn = moc_get_errfn();
+	moc_set_errfn(count_error);
+	nerrors = 0;
+	assert(! moc_init_fsm(&fsm, unsorted, 2, 0));
+	assert(! moc_init_fsm(&fsm, protocol, 1, MOC_FSMSTATES));
+	assert(nerrors == 2);
+	moc_set_errfn(errfn);
+}
+
+int main(void) {
+	test_fsm();
+	test_fsm_invalid();
+	return 0;
+}
@@ -0,0 +1,142 @@
+/*
+   Mocito is a mocking library for writing unit tests of C code.
+   Copyright (C) 2025 Carlos Rica Espinosa <jasampler@gmail.com>
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software Foundation,
+   Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+*/
+
+
+/*
+ * Tests of the type constants and of the type-generic macros of C11.
+ */
+
+#include "mocito.h"
+#include <stdio.h>
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Create the default function to manage the mocking-related errors. */
+void moc_error(void) { fprintf(stderr, "%s\n", moc_errmsg()); exit(1); }
+
+void test_type_constants(void) {
+	assert(MOC_TYPE_VOID == moc_type_void());
+	assert(MOC_TYPE_C == moc_type_c());
+	assert(MOC_TYPE_S == moc_type_s());
+	assert(MOC_TYPE_I == moc_type_i());
+	assert(MOC_TYPE_L == moc_type_l());
+	assert(MOC_TYPE_F == moc_type_f());
+	assert(MOC_TYPE_D == moc_type_d());
+	assert(MOC_TYPE_SC == moc_type_sc());
+	assert(MOC_TYPE_UC == moc_type_uc());
+	assert(MOC_TYPE_US == moc_type_us());
+	assert(MOC_TYPE_UI == moc_type_ui());
+	assert(MOC_TYPE_UL == moc_type_ul());
+	assert(MOC_TYPE_FN == moc_type_fn());
+	assert(MOC_TYPE_P == moc_type_p());
+	assert(MOC_TYPE_P_C == moc_type_p_c());
+	assert(MOC_TYPE_P_S == moc_type_p_s());
+	assert(MOC_TYPE_P_I == moc_type_p_i());
+	assert(MOC_TYPE_P_L == moc_type_p_l());
+	assert(MOC_TYPE_P_F == moc_type_p_f());
+	assert(MOC_TYPE_P_D == moc_type_p_d());
+	assert(MOC_TYPE_P_SC == moc_type_p_sc());
+	assert(MOC_TYPE_P_UC == moc_type_p_uc());
+	assert(MOC_TYPE_P_US == moc_type_p_us());
+	assert(MOC_TYPE_P_UI == moc_type_p_ui());
+	assert(MOC_TYPE_P_UL == moc_type_p_ul());
+	assert(MOC_TYPE_P_FN == moc_type_p_fn());
+	assert(MOC_TYPE_CP == moc_type_cp());
+	assert(MOC_TYPE_CP_C == moc_type_cp_c());
+	assert(MOC_TYPE_CP_S == moc_type_cp_s());
+	assert(MOC_TYPE_CP_I == moc_type_cp_i());
+	assert(MOC_TYPE_CP_L == moc_type_cp_l());
+	assert(MOC_TYPE_CP_F == moc_type_cp_f());
+	assert(MOC_TYPE_CP_D == moc_type_cp_d());
+	assert(MOC_TYPE_CP_SC == moc_type_cp_sc());
+	assert(MOC_TYPE_CP_UC == moc_type_cp_uc());
+	assert(MOC_TYPE_CP_US == moc_type_cp_us());
+	assert(MOC_TYPE_CP_UI == moc_type_cp_ui());
+	assert(MOC_TYPE_CP_UL == moc_type_cp_ul());
+	assert(MOC_TYPE_CP_FN == moc_type_cp_fn());
+}
+
+long store_value(const char *key, long value) {
+	return moc_get_l(moc_act(MOC_FN(store_value), MOC_TYPE_L,
+			moc_values_2(moc_cp_c(key), moc_l(value))));
+}
+
+void test_constant_rettype(void) {
+	char mem[1000];
+	moc_init(mem, sizeof(mem));
+	moc_given(MOC_FN(store_value),
+			moc_match_2(moc_eq_cstr("k"), moc_any_l()),
+			moc_respond_1(moc_return(moc_l(-1L))));
+	assert(store_value("k", 5L) == -1L);
+	switch (moc_get_type(moc_ul(1UL))) {
+		case MOC_TYPE_UL: break;
+		default: assert(0);
+	}
+}
+
+#if defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L
+
+struct point { int x, y; };
+
+int move_to(const char *label, unsigned char id, double x, struct point *p) {
+	return moc_get_i(MOC_ACT(move_to, MOC_TYPE_I, label, id, x, p));
+}
+
+void reset_all(void) {
+	MOC_ACT(reset_all, MOC_TYPE_VOID);
+}
+
+void test_generic_macros(void) {
+	char mem[1000];
+	const char *label = "a";
+	struct point pt;
+	unsigned short us = 3;
+	assert(MOC_TYPEOF(1) == MOC_TYPE_I);
+	assert(MOC_TYPEOF(1.0f) == MOC_TYPE_F);
+	assert(MOC_TYPEOF(label) == MOC_TYPE_CP_C);
+	assert(MOC_TYPEOF(&us) == MOC_TYPE_P_US);
+	assert(MOC_TYPEOF(&pt) == MOC_TYPE_P);
+	assert(moc_get_type(MOC_V(us)) == MOC_TYPE_US);
+	assert(moc_get_type(MOC_V(&pt)) == MOC_TYPE_P);
+	assert(moc_get_uc(MOC_V((unsigned char) 200)) == 200);
+	moc_init(mem, sizeof(mem));
+	moc_given(MOC_FN(move_to),
+			moc_match_4(moc_eq_cstr("a"), moc_eq(moc_uc(2)),
+				moc_gt(moc_d(0.0)), moc_any_p()),
+			moc_respond_1(moc_return(moc_i(7))));
+	moc_given(MOC_FN(reset_all), moc_match_0(),
+			moc_respond_1(moc_return(moc_void())));
+	assert(move_to(label, 2, 1.5, &pt) == 7);
+	reset_all();
+}
+
+#else
+
+void test_generic_macros(void) {
+}
+
+#endif
+
+int main(void) {
+	test_type_constants();
+	test_constant_rettype();
+	test_generic_macros();
+	return 0;
+}
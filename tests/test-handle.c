@@ -0,0 +1,176 @@
+/*
+   Mocito is a mocking library for writing unit tests of C code.
+   Copyright (C) 2025 Carlos Rica Espinosa <jasampler@gmail.com>
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software Foundation,
+   Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+*/
+
+/*
+ * Tests of mocks using handles of functions like the generated mocks.
+ */
+
+#include "mocito.h"
+#include <stdio.h>
+#include <assert.h>
+#include <stdlib.h>
+
+/* Create the default function to manage the mocking-related errors. */
+void moc_error(void) { fprintf(stderr, "%s\n", moc_errmsg()); exit(1); }
+
+int ifun0(void) {
+	static struct moc_handle moc_hnd = MOC_HANDLE(ifun0);
+	return moc_get_i(moc_act_h(&moc_hnd, moc_type_i(),
+			moc_values_0()));
+}
+
+int ifun1(char c) {
+	static struct moc_handle moc_hnd = MOC_HANDLE(ifun1);
+	return moc_get_i(moc_act_h(&moc_hnd, moc_type_i(),
+			moc_values_1(moc_c(c))));
+}
+
+MOC_STATIC_GIVEN_TABLE(fixture) = {
+	MOC_TROW_0(ifun0, MOC_TRET_I(10))
+};
+
+void test_handle(void) {
+	char mem[2000];
+
+	moc_init(mem, sizeof(mem));
+	moc_given(MOC_FN(ifun0),
+			moc_match_0(),
+			moc_respond_1(moc_return(moc_i(1))));
+	moc_given(MOC_FN(ifun1),
+			moc_match_1(moc_eq(moc_c('a'))),
+			moc_respond_1(moc_return(moc_i(2))));
+	assert(1 == ifun0());
+	assert(1 == ifun0());
+	assert(2 == ifun1('a'));
+	assert(2 == ifun1('a'));
+
+	/* The positions of the functions change after moc_init: */
+	moc_init(mem, sizeof(mem));
+	moc_given(MOC_FN(ifun1),
+			moc_match_1(moc_eq(moc_c('a'))),
+			moc_respond_1(moc_return(moc_i(3))));
+	moc_given(MOC_FN(ifun0),
+			moc_match_0(),
+			moc_respond_1(moc_return(moc_i(4))));
+	assert(4 == ifun0());
+	assert(3 == ifun1('a'));
+	assert(3 == ifun1('a'));
+}
+
+void test_handle_table(void) {
+	char mem[2000];
+
+	moc_init(mem, sizeof(mem));
+	moc_attach_table(fixture, sizeof(fixture) / sizeof(fixture[0]));
+	assert(10 == ifun0());
+	moc_given(MOC_FN(ifun0),
+			moc_match_0(),
+			moc_respond_1(moc_return(moc_i(5))));
+	assert(5 == ifun0());
+}
+
+void test_has_mappings(void) {
+	static struct moc_handle hnd0 = MOC_HANDLE(ifun0);
+	static struct moc_handle hnd1 = MOC_HANDLE(ifun1);
+	char mem[2000];
+
+	moc_init(mem, sizeof(mem));
+	assert(! moc_has_mappings(&hnd0, 0));
+	assert(! moc_has_mappings(&hnd1, 1));
+	moc_given(MOC_FN(ifun1),
+			moc_match_1(moc_any()),
+			moc_respond_1(moc_return(moc_i(1))));
+	assert(! moc_has_mappings(&hnd0, 0));
+	assert(moc_has_mappings(&hnd1, 1));
+	moc_given(MOC_FN(ifun0),
+			moc_match_0(),
+			moc_respond_1(moc_return(moc_i(2))));
+	assert(moc_has_mappings(&hnd0, 0));
+	assert(moc_has_mappings(&hnd1, 1));
+
+	moc_init(mem, sizeof(mem));
+	assert(! moc_has_mappings(&hnd0, 0));
+	moc_attach_table(fixture, sizeof(fixture) / sizeof(fixture[0]));
+	assert(moc_has_mappings(&hnd0, 0));
+	assert(! moc_has_mappings(&hnd1, 1));
+	/* Attaching another table forgets the cached results: */
+	moc_attach_table(fixture, 0);
+	assert(! moc_has_mappings(&hnd0, 0));
+	moc_attach_table(fixture, sizeof(fixture) / sizeof(fixture[0]));
+	assert(moc_has_mappings(&hnd0, 0));
+}
+
+static int npolls;
+
+static void count_poll(void) {
+	npolls++;
+}
+
+void test_has_mappings_poll(void) {
+	static struct moc_handle hnd = MOC_HANDLE(ifun0);
+	char mem[2000];
+
+	moc_init(mem, sizeof(mem));
+	moc_given(MOC_FN(ifun0),
+			moc_match_0(),
+			moc_respond_1(moc_return(moc_i(2))));
+	moc_set_pollfn(&count_poll);
+	npolls = 0;
+	/* A wrapper checks the mappings and acts, polling once: */
+	assert(moc_has_mappings(&hnd, 0));
+	assert(2 == moc_get_i(moc_act_h(&hnd, moc_type_i(), moc_values_0())));
+	assert(1 == npolls);
+	assert(2 == moc_get_i(moc_act_h(&hnd, moc_type_i(), moc_values_0())));
+	assert(2 == npolls);
+	moc_set_pollfn(0);
+}
+
+void test_act_batch(void) {
+	static struct moc_handle hnd = MOC_HANDLE(hash);
+	char mem[2000];
+	struct moc_value params[8], results[4];
+	int i;
+
+	moc_init(mem, sizeof(mem));
+	moc_given("hash", moc_match_2(moc_lt(moc_i(2)), moc_any()),
+			moc_respond_1(moc_return(moc_ul(10))));
+	moc_given("hash", moc_match_2(moc_any(), moc_eq(moc_c('z'))),
+			moc_respond_1(moc_return(moc_ul(20))));
+	moc_given("hash", moc_match_2(moc_any(), moc_any()),
+			moc_respond_2(moc_return(moc_ul(30)),
+				moc_return(moc_ul(31))));
+	for (i = 0; i < 4; i++) {
+		params[2 * i] = moc_i(i);
+		params[2 * i + 1] = moc_c('z' - i % 2);
+	}
+	moc_act_batch(&hnd, moc_type_ul(), 4, 2, params, results);
+	assert(10 == moc_get_ul(results[0]));
+	assert(10 == moc_get_ul(results[1]));
+	assert(20 == moc_get_ul(results[2]));
+	assert(31 == moc_get_ul(results[3]));
+}
+
+int main(void) {
+	test_handle();
+	test_handle_table();
+	test_has_mappings();
+	test_has_mappings_poll();
+	test_act_batch();
+	return 0;
+}
@@ -0,0 +1,81 @@
+/*
+   Mocito is a mocking library for writing unit tests of C code.
+   Copyright (C) 2025 Carlos Rica Espinosa <jasampler@gmail.com>
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software Foundation,
+   Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+*/
+
+
+/*
+ * Tests of the values created by the inline functions of the header.
+ */
+
+#define MOC_INLINE
+#include "mocito.h"
+#include <stdio.h>
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Create the default function to manage the mocking-related errors. */
+void moc_error(void) { fprintf(stderr, "%s\n", moc_errmsg()); exit(1); }
+
+double average(const int *values, unsigned char n, double def) {
+	return moc_get_d(moc_act(MOC_FN(average), moc_type_d(),
+			moc_values_3(moc_cp_i(values), moc_uc(n), moc_d(def))));
+}
+
+const char *name_of(signed char id, moc_fnptr fn) {
+	return moc_get_cp_c(moc_act(MOC_FN(name_of), moc_type_cp_c(),
+			moc_values_2(moc_sc(id), moc_fn(fn))));
+}
+
+void test_inline_values(void) {
+	int i = 3;
+	assert(moc_get_c(moc_c('x')) == 'x');
+	assert(moc_get_s(moc_s(-300)) == -300);
+	assert(moc_get_l(moc_l(-70000L)) == -70000L);
+	assert(moc_get_f(moc_f(1.5f)) == 1.5f);
+	assert(moc_get_ul(moc_ul(4000000000UL)) == 4000000000UL);
+	assert(moc_get_p_i(moc_p_i(&i)) == &i);
+	assert(moc_get_type(moc_i(1)) == moc_type_i());
+	assert(moc_get_type(moc_p(&i)) == moc_type_p());
+	assert(moc_get_type(moc_cp_us(0)) == moc_type_cp_us());
+	assert(moc_get_type(moc_void()) == moc_type_void());
+	assert(moc_get_type(moc_fn(MOC_FP(test_inline_values)))
+			== moc_type_fn());
+}
+
+void test_inline_mocks(void) {
+	char mem[2000];
+	int values[2] = { 1, 2 };
+	moc_init(mem, sizeof(mem));
+	moc_given(MOC_FN(average),
+			moc_match_3(moc_any_cp_i(), moc_eq(moc_uc(2)),
+				moc_lt(moc_d(0.5))),
+			moc_respond_1(moc_return(moc_d(1.5))));
+	moc_given(MOC_FN(name_of),
+			moc_match_2(moc_eq(moc_sc(-1)),
+				moc_eq(moc_fn(MOC_FP(average)))),
+			moc_respond_1(moc_return(moc_cp_c("avg"))));
+	assert(average(values, 2, 0.0) == 1.5);
+	assert(strcmp(name_of(-1, MOC_FP(average)), "avg") == 0);
+}
+
+int main(void) {
+	test_inline_values();
+	test_inline_mocks();
+	return 0;
+}
@@ -0,0 +1,114 @@
+/*
+   Mocito is a mocking library for writing unit tests of C code.
+   Copyright (C) 2025 Carlos Rica Espinosa <jasampler@gmail.com>
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software Foundation,
+   Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+*/
+
+/*
+ * Tests of the listener receiving commands from a Unix socket, built
+ * with src/mocito-listen.c and -lpthread.
+ */
+
+#define _POSIX_C_SOURCE 200112L
+
+#include "mocito.h"
+#include "mocito-listen.h"
+#include <stdio.h>
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+/* Create the default function to manage the mocking-related errors. */
+void moc_error(void) { fprintf(stderr, "%s\n", moc_errmsg()); exit(1); }
+
+long get_size(long size) {
+	return moc_get_l(moc_act(MOC_FN(get_size), moc_type_l(),
+			moc_values_1(moc_l(size))));
+}
+
+/* Sends the command and calls to the mock until the reply is received,
+ * because the commands are applied before the calls to the mocks. */
+static void send_command(int fd, const char *cmd, char *reply,
+		size_t size) {
+	struct timespec delay;
+	size_t len;
+	ssize_t n;
+	int i;
+	delay.tv_sec = 0;
+	delay.tv_nsec = 1000000;
+	n = write(fd, cmd, strlen(cmd));
+	assert(n == (ssize_t) strlen(cmd));
+	len = 0;
+	for (i = 0; i < 5000 && (len == 0 || reply[len - 1] != '\n'); i++) {
+		get_size(0);
+		n = recv(fd, reply + len, size - 1 - len, MSG_DONTWAIT);
+		if (n > 0) {
+			len += (size_t) n;
+		} else {
+			nanosleep(&delay, NULL);
+		}
+	}
+	reply[len] = '\0';
+}
+
+void test_listen(void) {
+	char mem[3000], store[200], path[64], reply[100], line[1200];
+	struct sockaddr_un addr;
+	int fd;
+
+	moc_init(mem, sizeof(mem));
+	moc_init_store(store, sizeof(store));
+	moc_given(MOC_FN(get_size), moc_match_1(moc_any()),
+			moc_respond_1(moc_return(moc_l(1))));
+	sprintf(path, "/tmp/mocito-test-%d.sock", (int) getpid());
+	assert(moc_listen(path) == 0);
+	fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	assert(fd >= 0);
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	strcpy(addr.sun_path, path);
+	assert(connect(fd, (struct sockaddr *) &addr, sizeof(addr)) == 0);
+	assert(get_size(5) == 1);
+
+	send_command(fd, "reset; given get_size any returns 2L\n",
+			reply, sizeof(reply));
+	assert(strcmp(reply, "ok\n") == 0);
+	assert(get_size(5) == 2);
+	send_command(fd, "unknown get_size\n", reply, sizeof(reply));
+	assert(strncmp(reply, "error: ", 7) == 0);
+	assert(get_size(5) == 2);
+
+	/* The lines too long are not applied cut: */
+	memset(line, ' ', sizeof(line));
+	memcpy(line, "reset; given get_size any returns 3L", 36);
+	strcpy(line + sizeof(line) - 2, "\n");
+	send_command(fd, line, reply, sizeof(reply));
+	assert(strcmp(reply, "error: line too long\n") == 0);
+	assert(get_size(5) == 2);
+
+	moc_set_pollfn(NULL);
+	close(fd);
+	unlink(path);
+}
+
+int main(void) {
+	test_listen();
+	return 0;
+}
@@ -0,0 +1,80 @@
+/*
+   Mocito is a mocking library for writing unit tests of C code.
+   Copyright (C) 2025 Carlos Rica Espinosa <jasampler@gmail.com>
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software Foundation,
+   Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+*/
+
+
+
+/*
+ * Tests of the mocks generated by mocgen for mocgen-sample.h, which are
+ * compiled from mocgen-sample.c.
+ */
+
+#include "mocito.h"
+#include <stdio.h>
+#include <assert.h>
+#include <stdlib.h>
+
+/* Create the default function to manage the mocking-related errors. */
+void moc_error(void) { fprintf(stderr, "%s\n", moc_errmsg()); exit(1); }
+
+#include "mocgen-sample.c"
+
+void test_mocgen(void) {
+	char mem[4000];
+	char buf[16];
+	struct smp_file *file;
+	int nclosed = 0;
+	moc_init(mem, sizeof(mem));
+	moc_given(MOC_FN(smp_open), moc_match_2(moc_eq_cstr("a.txt"),
+			moc_eq(moc_i(SMP_READ))),
+			moc_respond_1(moc_return(moc_p(buf))));
+	moc_given(MOC_FN(smp_read), moc_match_3(moc_eq(moc_p(buf)), moc_any(),
+			moc_gt(moc_ul(4))),
+			moc_respond_1(moc_return(moc_l(5))));
+	moc_given(MOC_FN(smp_close), moc_match_1(moc_any()),
+			moc_respond_1(moc_count(moc_p_i(&nclosed))));
+	moc_given(MOC_FN(smp_scale), moc_match_2(moc_any(), moc_any()),
+			moc_respond_1(moc_return(moc_d(2.5))));
+	file = smp_open("a.txt", SMP_READ);
+	assert((char *) file == buf);
+	assert(smp_read(file, buf, sizeof(buf)) == 5);
+	smp_close(file);
+	assert(nclosed == 1);
+	assert(smp_scale(1.0, 2.5f) == 2.5);
+}
+
+void test_mocgen_array(void) {
+	char mem[4000];
+	struct moc_matcher matchers[8];
+	struct moc_responder responders[1];
+	int i;
+	moc_init(mem, sizeof(mem));
+	for (i = 0; i < 8; i++) {
+		matchers[i] = moc_any();
+	}
+	matchers[7] = moc_eq(moc_i(8));
+	responders[0] = moc_return(moc_i(36));
+	moc_given_v(MOC_FN(smp_sum8), 8, matchers, 1, responders);
+	assert(smp_sum8(1, 2, 3, 4, 5, 6, 7, 8) == 36);
+}
+
+int main(void) {
+	test_mocgen();
+	test_mocgen_array();
+	return 0;
+}
@@ -268,9 +268,53 @@ void test_value_params(void) {
 	assert(-7.0 == dfun7(mem,d,f,l,i,s,c));
 }
 
+static int nerrors;
+
+static void count_error(void) {
+	nerrors++;
+}
+
+void test_param_types(void) {
+	char mem[4000];
+	moc_errfn_t errfn;
+	moc_init(mem, sizeof(mem));
+	moc_given(MOC_FN(ifun7), moc_match_7(moc_any(), moc_any(),
+				moc_eq(moc_i(1)), moc_any(), moc_any(),
+				moc_any(), moc_any()),
+			moc_respond_1(moc_return(moc_i(1))));
+	moc_given(MOC_FN(ifun7), moc_match_7(moc_any(), moc_any(),
+				moc_eq(moc_l(2)), moc_any(), moc_any(),
+				moc_any(), moc_any()),
+			moc_respond_1(moc_return(moc_i(2))));
+	moc_given(MOC_FN(ifun7), moc_match_7(moc_any(), moc_any(),
+				moc_any(), moc_any(), moc_any(),
+				moc_gt(moc_d(0.0)), moc_any()),
+			moc_respond_1(moc_return(moc_i(3))));
+	assert(ifun7('a', 1, 1, 1L, 1.0f, 1.0, NULL) == 1);
+	/* The types are checked when the previous matchers match: */
+	errfn = moc_get_errfn();
+	moc_set_errfn(count_error);
+	nerrors = 0;
+	assert(ifun7('a', 1, 2, 1L, 1.0f, 1.0, NULL) == 0);
+	assert(nerrors == 1);
+	moc_set_errfn(errfn);
+	moc_init(mem, sizeof(mem));
+	moc_given(MOC_FN(ifun7), moc_match_7(moc_any(), moc_any(),
+				moc_any(), moc_any(), moc_any(),
+				moc_gt(moc_d(0.0)), moc_eq(moc_p(mem))),
+			moc_respond_1(moc_return(moc_i(3))));
+	moc_given(MOC_FN(ifun7), moc_match_7(moc_eq(moc_c('b')),
+				moc_any(), moc_any(), moc_any(), moc_any(),
+				moc_any(), moc_eq(moc_p(NULL))),
+			moc_respond_1(moc_return(moc_i(4))));
+	assert(ifun7('a', 1, 2, 1L, 1.0f, 1.0, mem) == 3);
+	assert(ifun7('b', 1, 2, 1L, 1.0f, -1.0, NULL) == 4);
+}
+
 int main(void) {
 	test_num_params();
 	test_value_params();
+	test_param_types();
 	return 0;
 }
 
@@ -0,0 +1,211 @@
+/*
+   Mocito is a mocking library for writing unit tests of C code.
+   Copyright (C) 2025 Carlos Rica Espinosa <jasampler@gmail.com>
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software Foundation,
+   Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+*/
+
+/*
+ * Tests of mocks replaying the calls recorded by spies.
+ */
+
+#include "mocito.h"
+#include <stdio.h>
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Create the default function to manage the mocking-related errors. */
+void moc_error(void) { fprintf(stderr, "%s\n", moc_errmsg()); exit(1); }
+
+/* Real functions simulating a service with changing responses. */
+static int nreads;
+
+long real_recv(int fd, char *buf, unsigned long size) {
+	const char *msg;
+	msg = nreads++ == 0 ? "first" : "second";
+	strncpy(buf, msg, size);
+	return fd == 0 ? -1L : (long) strlen(msg);
+}
+
+int real_lookup(const char *key) {
+	return key[0] + nreads;
+}
+
+struct moc_value fwd_recv(struct moc_call *call, struct moc_value data) {
+	if (sizeof(data)) {} /* unused warning */
+	return moc_l(real_recv(moc_get_i(call->params[0]),
+			moc_get_p_c(call->params[1]),
+			moc_get_ul(call->params[2])));
+}
+
+struct moc_value fwd_lookup(struct moc_call *call, struct moc_value data) {
+	if (sizeof(data)) {} /* unused warning */
+	return moc_i(real_lookup(moc_get_cp_c(call->params[0])));
+}
+
+long recv_msg(int fd, char *buf, unsigned long size) {
+	return moc_get_l(moc_act(MOC_FN(recv_msg), moc_type_l(),
+			moc_values_3(moc_i(fd), moc_p_c(buf), moc_ul(size))));
+}
+
+int lookup(const char *key) {
+	return moc_get_i(moc_act(MOC_FN(lookup), moc_type_i(),
+			moc_values_1(moc_cp_c(key))));
+}
+
+void test_record_replay(void) {
+	char mem[4000], trace[500], buf[10];
+	char key[4];
+	struct moc_spy recvspy, lookupspy;
+	struct moc_recorder rec;
+
+	/* Records the calls to the real functions: */
+	moc_init(mem, sizeof(mem));
+	moc_init_recorder(&rec, trace, sizeof(trace));
+	moc_init_spy(&recvspy, fwd_recv);
+	moc_spy_record(&recvspy, &rec, 2, 0);
+	moc_init_spy(&lookupspy, fwd_lookup);
+	moc_spy_record(&lookupspy, &rec, 0, 0);
+	moc_given(MOC_FN(recv_msg),
+			moc_match_3(moc_any(), moc_any(), moc_any()),
+			moc_respond_1(moc_spy(&recvspy)));
+	moc_given(MOC_FN(lookup),
+			moc_match_1(moc_any()),
+			moc_respond_1(moc_spy(&lookupspy)));
+	nreads = 0;
+	strcpy(key, "abc");
+	assert(lookup(key) == 'a');
+	assert(recv_msg(3, buf, sizeof(buf)) == 5);
+	assert(recv_msg(3, buf, sizeof(buf)) == 6);
+	assert(recv_msg(0, buf, sizeof(buf)) == -1);
+	assert(lookup("abc") == 'a' + 3);
+	assert(rec.nlost == 0);
+
+	/* Replays them without calling to the real functions: */
+	moc_init(mem, sizeof(mem));
+	assert(moc_replay(trace, rec.len) == 5);
+	nreads = 100;
+	memset(buf, 0, sizeof(buf));
+	assert(recv_msg(3, buf, sizeof(buf)) == 5);
+	assert(strncmp(buf, "first", 5) == 0);
+	assert(recv_msg(3, buf, sizeof(buf)) == 6);
+	assert(strcmp(buf, "second") == 0);
+	assert(recv_msg(0, buf, sizeof(buf)) == -1);
+	assert(lookup("abc") == 'a');
+	assert(lookup("abc") == 'a' + 3);
+	assert(nreads == 100);
+}
+
+void test_record_full(void) {
+	char mem[2000], trace[40];
+	struct moc_spy spy;
+	struct moc_recorder rec;
+
+	moc_init(mem, sizeof(mem));
+	moc_init_recorder(&rec, trace, sizeof(trace));
+	moc_init_spy(&spy, fwd_lookup);
+	moc_spy_record(&spy, &rec, 0, 0);
+	moc_given(MOC_FN(lookup),
+			moc_match_1(moc_any()),
+			moc_respond_1(moc_spy(&spy)));
+	nreads = 0;
+	assert(lookup("a") == 'a');
+	assert(lookup("b") == 'b');
+	assert(rec.nlost == 1);
+
+	moc_init(mem, sizeof(mem));
+	assert(moc_replay(trace, rec.len) == 1);
+	assert(moc_replay("MOCX", 4) == 0);
+	assert(lookup("a") == 'a');
+}
+
+void test_record_many(void) {
+	static char mem[40000], trace[8000];
+	char key[4];
+	struct moc_spy spy;
+	struct moc_recorder rec;
+	int i, n;
+
+	moc_init(mem, sizeof(mem));
+	moc_init_recorder(&rec, trace, sizeof(trace));
+	moc_init_spy(&spy, fwd_lookup);
+	moc_spy_record(&spy, &rec, 0, 0);
+	moc_given(MOC_FN(lookup),
+			moc_match_1(moc_any()),
+			moc_respond_1(moc_spy(&spy)));
+	/* More different keys than the calls found by hash: */
+	for (n = 0; n < 2; n++) {
+		for (i = 0; i < 80; i++) {
+			sprintf(key, "k%d", i);
+			nreads = n;
+			assert(lookup(key) == 'k' + n);
+		}
+	}
+	assert(rec.nlost == 0);
+
+	moc_init(mem, sizeof(mem));
+	assert(moc_replay(trace, rec.len) == 160);
+	for (n = 0; n < 2; n++) {
+		for (i = 79; i >= 0; i--) {
+			sprintf(key, "k%d", i);
+			assert(lookup(key) == 'k' + n);
+		}
+	}
+}
+
+static int nerrors;
+
+static void count_error(void) {
+	nerrors++;
+}
+
+void test_record_error(void) {
+	char mem[4000], trace[500];
+	struct moc_spy spy;
+	struct moc_recorder rec;
+	moc_errfn_t errfn;
+	unsigned long ncalls;
+
+	moc_init(mem, sizeof(mem));
+	moc_init_recorder(&rec, trace, sizeof(trace));
+	moc_init_spy(&spy, fwd_lookup);
+	moc_spy_record(&spy, &rec, 0, 0);
+	moc_given(MOC_FN(lookup),
+			moc_match_1(moc_any()),
+			moc_respond_1(moc_spy(&spy)));
+	nreads = 0;
+	assert(lookup("a") == 'a');
+	assert(lookup("b") == 'b');
+	assert(lookup("c") == 'c');
+
+	/* Stops at the first call whose mapping cannot be added: */
+	moc_init(mem, 400);
+	errfn = moc_get_errfn();
+	moc_set_errfn(count_error);
+	nerrors = 0;
+	ncalls = moc_replay(trace, rec.len);
+	moc_set_errfn(errfn);
+	assert(nerrors == 1);
+	assert(ncalls < 3);
+}
+
+int main(void) {
+	test_record_replay();
+	test_record_full();
+	test_record_many();
+	test_record_error();
+	return 0;
+}
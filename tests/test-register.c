@@ -0,0 +1,155 @@
+/*
+   Mocito is a mocking library for writing unit tests of C code.
+   Copyright (C) 2025 Carlos Rica Espinosa <jasampler@gmail.com>
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software Foundation,
+   Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+*/
+
+
+
+/*
+ * Tests of the register files responding to the register accessors.
+ */
+
+#include "mocito.h"
+#include <stdio.h>
+#include <assert.h>
+#include <stdlib.h>
+
+/* Create the default function to manage the mocking-related errors. */
+void moc_error(void) { fprintf(stderr, "%s\n", moc_errmsg()); exit(1); }
+
+unsigned int reg_read(unsigned long addr) {
+	return moc_get_ui(moc_act(MOC_FN(reg_read), moc_type_ui(),
+			moc_values_1(moc_ul(addr))));
+}
+
+void reg_write(unsigned long addr, unsigned int value) {
+	moc_act(MOC_FN(reg_write), moc_type_void(),
+			moc_values_2(moc_ul(addr), moc_ui(value)));
+}
+
+#define REG_CTRL   0x00
+#define REG_STATUS 0x04
+#define REG_IRQ    0x08
+#define REG_DATA   0x0C
+
+/* Starting the device sets the ready bit of the status register. */
+static void on_ctrl_write(struct moc_regfile *file,
+		struct moc_register *reg, unsigned long value) {
+	if (sizeof(reg)) {} /* unused warning */
+	if (value & 1) {
+		moc_find_register(file, REG_STATUS)->value |= 0x80;
+	}
+}
+
+/* Reading the data register gets the next data raising the interrupt. */
+static void on_data_read(struct moc_regfile *file,
+		struct moc_register *reg, unsigned long value) {
+	moc_find_register(file, REG_IRQ)->value |= 0x01;
+	reg->value = value + 1;
+}
+
+static void given_regfile(struct moc_regfile *file) {
+	moc_given(MOC_FN(reg_read), moc_match_1(moc_any()),
+			moc_respond_1(moc_read_register(file)));
+	moc_given(MOC_FN(reg_write), moc_match_2(moc_any(), moc_any()),
+			moc_respond_1(moc_write_register(file)));
+}
+
+void test_register(void) {
+	char mem[2000];
+	struct moc_register regs[] = {
+		MOC_REGISTER_HOOKS(REG_CTRL, 0, 0, 0, 0, &on_ctrl_write),
+		MOC_REGISTER(REG_STATUS, 0x01, 0x01, 0),
+		MOC_REGISTER(REG_IRQ, 0, 0, 0xFF),
+		MOC_REGISTER_HOOKS(REG_DATA, 10, 0, 0, &on_data_read, 0)
+	};
+	struct moc_regfile file;
+	moc_init(mem, sizeof(mem));
+	assert(moc_init_regfile(&file, regs, 4, moc_type_ui()));
+	assert(file.stride == 4);
+	given_regfile(&file);
+
+	/* Read to clear bit: */
+	assert(reg_read(REG_STATUS) == 0x01);
+	assert(reg_read(REG_STATUS) == 0x00);
+	reg_write(REG_CTRL, 1);
+	assert(reg_read(REG_CTRL) == 1);
+	assert(reg_read(REG_STATUS) == 0x80);
+
+	/* Write 1 to clear bits: */
+	assert(reg_read(REG_DATA) == 11);
+	assert(reg_read(REG_DATA) == 12);
+	assert(reg_read(REG_IRQ) == 0x01);
+	regs[2].value = 0x06;
+	reg_write(REG_IRQ, 0x02);
+	assert(reg_read(REG_IRQ) == 0x04);
+
+	assert(regs[0].nwrites == 1 && regs[0].nreads == 1);
+	assert(regs[1].nreads == 3 && regs[1].nwrites == 0);
+	assert(regs[2].nreads == 2 && regs[2].nwrites == 1);
+	assert(regs[3].nreads == 2);
+}
+
+static int nerrors;
+
+static void count_error(void) {
+	nerrors++;
+}
+
+void test_register_sparse(void) {
+	char mem[2000];
+	struct moc_register regs[] = {
+		MOC_REGISTER(0x10, 1, 0, 0),
+		MOC_REGISTER(0x14, 2, 0, 0),
+		MOC_REGISTER(0x100, 3, 0, 0),
+		MOC_REGISTER(0x2000, 4, 0, 0)
+	};
+	struct moc_regfile file;
+	moc_errfn_t errfn;
+	moc_init(mem, sizeof(mem));
+	assert(moc_init_regfile(&file, regs, 4, moc_type_ui()));
+	assert(file.stride == 0);
+	given_regfile(&file);
+	assert(reg_read(0x10) == 1);
+	assert(reg_read(0x2000) == 4);
+	reg_write(0x100, 30);
+	assert(reg_read(0x100) == 30);
+	assert(moc_find_register(&file, 0x18) == 0);
+
+	/* The unknown addresses are errors, also reported for the type of
+	 * the empty value returned: */
+	errfn = moc_get_errfn();
+	moc_set_errfn(count_error);
+	nerrors = 0;
+	reg_read(0x18);
+	assert(nerrors == 2);
+	nerrors = 0;
+	reg_write(0x0, 1);
+	assert(nerrors == 1);
+	nerrors = 0;
+	assert(! moc_init_regfile(&file, regs + 1, 2, moc_type_d()));
+	regs[2].addr = 0x14;
+	assert(! moc_init_regfile(&file, regs, 4, moc_type_ui()));
+	assert(nerrors == 2);
+	moc_set_errfn(errfn);
+}
+
+int main(void) {
+	test_register();
+	test_register_sparse();
+	return 0;
+}
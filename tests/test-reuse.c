@@ -0,0 +1,126 @@
+/*
+   Mocito is a mocking library for writing unit tests of C code.
+   Copyright (C) 2025 Carlos Rica Espinosa <jasampler@gmail.com>
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software Foundation,
+   Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+*/
+
+
+/*
+ * Tests of the reuse of mappings with equal fingerprints.
+ */
+
+#include "mocito.h"
+#include <stdio.h>
+#include <assert.h>
+#include <stdlib.h>
+
+/* Create the default function to manage the mocking-related errors. */
+void moc_error(void) { fprintf(stderr, "%s\n", moc_errmsg()); exit(1); }
+
+int read_sensor(int id) {
+	return moc_get_i(moc_act(MOC_FN(read_sensor), moc_type_i(),
+			moc_values_1(moc_i(id))));
+}
+
+static int nsetups, limit;
+
+void setup_sensors(void) {
+	nsetups++;
+	moc_given(MOC_FN(read_sensor), moc_match_1(moc_eq(moc_i(1))),
+			moc_respond_1(moc_return(moc_i(10))));
+	moc_given(MOC_FN(read_sensor), moc_match_1(moc_eq(moc_i(1))),
+			moc_respond_1(moc_return(moc_i(11))));
+	moc_given(MOC_FN(read_sensor), moc_match_1(moc_gt(moc_i(limit))),
+			moc_respond_1(moc_return(moc_i(-1))));
+}
+
+void test_fingerprint(void) {
+	char mem[2000];
+	unsigned long empty, fp;
+	moc_init(mem, sizeof(mem));
+	empty = moc_fingerprint();
+	limit = 5;
+	setup_sensors();
+	fp = moc_fingerprint();
+	assert(fp != empty);
+	moc_init(mem, sizeof(mem));
+	assert(moc_fingerprint() == empty);
+	setup_sensors();
+	assert(moc_fingerprint() == fp);
+	moc_init(mem, sizeof(mem));
+	limit = 6;
+	setup_sensors();
+	assert(moc_fingerprint() != fp);
+}
+
+void test_reuse(void) {
+	char mem[2000];
+	moc_init(mem, sizeof(mem));
+	limit = 5;
+	nsetups = 0;
+	assert(! moc_reuse(setup_sensors));
+	assert(nsetups == 1);
+	assert(read_sensor(1) == 10);
+	assert(read_sensor(9) == -1);
+
+	/* The same setup keeps the mappings from the first response: */
+	assert(moc_reuse(setup_sensors));
+	assert(nsetups == 2);
+	assert(read_sensor(1) == 10);
+	assert(read_sensor(1) == 11);
+	assert(moc_reuse(setup_sensors));
+	assert(read_sensor(1) == 10);
+
+	/* A different setup adds its mappings again: */
+	limit = 8;
+	assert(! moc_reuse(setup_sensors));
+	assert(nsetups == 5);
+	assert(read_sensor(9) == -1);
+	assert(read_sensor(1) == 10);
+	assert(moc_reuse(setup_sensors));
+}
+
+void setup_copy(void) {
+	setup_sensors();
+}
+
+void test_reuse_other(void) {
+	char mem[2000];
+	moc_init(mem, sizeof(mem));
+	limit = 5;
+	nsetups = 0;
+	assert(! moc_reuse(setup_sensors));
+	assert(read_sensor(1) == 10);
+	/* Another setup runs once even if it adds equal mappings: */
+	assert(! moc_reuse(setup_copy));
+	assert(nsetups == 2);
+	assert(read_sensor(1) == 10);
+	assert(moc_reuse(setup_copy));
+	assert(nsetups == 3);
+	/* The mappings added after the setup are not reused: */
+	moc_given(MOC_FN(read_sensor), moc_match_1(moc_eq(moc_i(2))),
+			moc_respond_1(moc_return(moc_i(20))));
+	assert(! moc_reuse(setup_copy));
+	assert(nsetups == 4);
+	assert(read_sensor(1) == 10);
+}
+
+int main(void) {
+	test_fingerprint();
+	test_reuse();
+	test_reuse_other();
+	return 0;
+}
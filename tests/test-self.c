@@ -0,0 +1,136 @@
+/*
+   Mocito is a mocking library for writing unit tests of C code.
+   Copyright (C) 2025 Carlos Rica Espinosa <jasampler@gmail.com>
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software Foundation,
+   Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+*/
+
+
+/*
+ * Tests of the mocks of interfaces with mappings for each instance.
+ */
+
+#include "mocito.h"
+#include <stdio.h>
+#include <assert.h>
+#include <stdlib.h>
+
+/* Create the default function to manage the mocking-related errors. */
+void moc_error(void) { fprintf(stderr, "%s\n", moc_errmsg()); exit(1); }
+
+struct shape {
+	const struct shape_ops *ops;
+};
+
+struct shape_ops {
+	double (*area)(const struct shape *self);
+	void (*scale)(struct shape *self, double factor);
+};
+
+/* Mock vtable as generated by mocgen -v: */
+static double shape_ops_area(const struct shape *self) {
+	static struct moc_handle moc_hnd = MOC_HANDLE(shape_ops.area);
+	return moc_get_d(moc_act_self(&moc_hnd,
+			(const void *) self, moc_type_d(),
+			moc_values_1(moc_cp((const void *) self))));
+}
+
+static void shape_ops_scale(struct shape *self, double factor) {
+	static struct moc_handle moc_hnd = MOC_HANDLE(shape_ops.scale);
+	moc_act_self(&moc_hnd,
+			(const void *) self, moc_type_void(),
+			moc_values_2(moc_p((void *) self), moc_d(factor)));
+}
+
+const struct shape_ops moc_shape_ops = {
+	shape_ops_area,
+	shape_ops_scale
+};
+
+/* Code under test using the interface: */
+static double total_area(struct shape **shapes, int n) {
+	double total = 0.0;
+	int i;
+	for (i = 0; i < n; i++) {
+		total += shapes[i]->ops->area(shapes[i]);
+	}
+	return total;
+}
+
+void test_self(void) {
+	char mem[4000];
+	struct shape a, b, c;
+	struct shape *shapes[3];
+	int nscaled = 0;
+	a.ops = b.ops = c.ops = &moc_shape_ops;
+	shapes[0] = &a;
+	shapes[1] = &b;
+	shapes[2] = &c;
+	moc_init(mem, sizeof(mem));
+	moc_given_self(&a, "shape_ops.area", moc_match_1(moc_any()),
+			moc_respond_1(moc_return(moc_d(1.0))));
+	moc_given_self(&b, "shape_ops.area", moc_match_1(moc_any()),
+			moc_respond_1(moc_return(moc_d(2.0))));
+	moc_given("shape_ops.area", moc_match_1(moc_any()),
+			moc_respond_1(moc_return(moc_d(10.0))));
+	moc_given_self(&c, "shape_ops.scale", moc_match_2(moc_any(),
+				moc_gt(moc_d(1.0))),
+			moc_respond_1(moc_count(moc_p_i(&nscaled))));
+	assert(total_area(shapes, 3) == 13.0);
+	assert(total_area(shapes, 3) == 13.0);
+	c.ops->scale(&c, 2.0);
+	assert(nscaled == 1);
+
+	/* The mappings added later for an instance are found: */
+	moc_given_self(&c, "shape_ops.area", moc_match_1(moc_any()),
+			moc_respond_1(moc_return(moc_d(3.0))));
+	assert(total_area(shapes, 3) == 6.0);
+
+	/* The instances are searched again after moc_init: */
+	moc_init(mem, sizeof(mem));
+	moc_given("shape_ops.area", moc_match_1(moc_any()),
+			moc_respond_1(moc_return(moc_d(5.0))));
+	moc_given_self(&b, "shape_ops.area", moc_match_1(moc_any()),
+			moc_respond_1(moc_return(moc_d(0.5))));
+	assert(total_area(shapes, 3) == 10.5);
+}
+
+/* More instances than the slots of the cache: */
+void test_self_many(void) {
+	static char mem[100000];
+	static struct shape many[100];
+	static struct shape *shapes[100];
+	int i;
+	moc_init(mem, sizeof(mem));
+	for (i = 0; i < 100; i++) {
+		many[i].ops = &moc_shape_ops;
+		shapes[i] = many + i;
+		if (i % 2 == 0) {
+			moc_given_self(many + i, "shape_ops.area",
+					moc_match_1(moc_any()),
+					moc_respond_1(moc_return(moc_d(1.0))));
+		}
+	}
+	moc_given("shape_ops.area", moc_match_1(moc_any()),
+			moc_respond_1(moc_return(moc_d(2.0))));
+	assert(total_area(shapes, 100) == 150.0);
+	assert(total_area(shapes, 100) == 150.0);
+}
+
+int main(void) {
+	test_self();
+	test_self_many();
+	return 0;
+}
@@ -0,0 +1,138 @@
+/*
+   Mocito is a mocking library for writing unit tests of C code.
+   Copyright (C) 2025 Carlos Rica Espinosa <jasampler@gmail.com>
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software Foundation,
+   Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+*/
+
+/*
+ * Tests of mocks with spies calling to the real functions.
+ */
+
+#include "mocito.h"
+#include <stdio.h>
+#include <assert.h>
+#include <stdlib.h>
+
+/* Create the default function to manage the mocking-related errors. */
+void moc_error(void) { fprintf(stderr, "%s\n", moc_errmsg()); exit(1); }
+
+/* Simulated clock that advances one tick on each read. */
+static unsigned long ticks;
+
+unsigned long fake_clock(void) {
+	return ++ticks;
+}
+
+int real_add(int a, long b) {
+	ticks += 100; /* simulated duration of the real function */
+	return a + (int) b;
+}
+
+struct moc_value fwd_add(struct moc_call *call, struct moc_value data) {
+	if (sizeof(data)) {} /* unused warning */
+	return moc_i(real_add(moc_get_i(call->params[0]),
+			moc_get_l(call->params[1])));
+}
+
+int add(int a, long b) {
+	return moc_get_i(moc_act(MOC_FN(add), moc_type_i(),
+			moc_values_2(moc_i(a), moc_l(b))));
+}
+
+void test_spy(void) {
+	char mem[2000];
+	struct moc_spy spy;
+
+	moc_init(mem, sizeof(mem));
+	moc_init_spy(&spy, fwd_add);
+	moc_given(MOC_FN(add),
+			moc_match_2(moc_eq(moc_i(0)), moc_any()),
+			moc_respond_1(moc_return(moc_i(-1))));
+	moc_given(MOC_FN(add),
+			moc_match_2(moc_any(), moc_any()),
+			moc_respond_1(moc_spy(&spy)));
+
+	assert(-1 == add(0, 5L));
+	assert(spy.ncalls == 0);
+	assert(7 == add(3, 4L));
+	assert(12 == add(2, 10L));
+	assert(spy.ncalls == 2);
+	assert(spy.nparams == 2);
+	assert(moc_get_i(spy.params[0]) == 2);
+	assert(moc_get_l(spy.params[1]) == 10L);
+	assert(moc_get_i(spy.result) == 12);
+	assert(spy.realtime == 0);
+	assert(spy.moctime == 0);
+}
+
+void test_spy_time(void) {
+	char mem[2000];
+	struct moc_spy spy;
+
+	moc_init(mem, sizeof(mem));
+	moc_set_clock(fake_clock);
+	moc_init_spy(&spy, fwd_add);
+	moc_given(MOC_FN(add),
+			moc_match_2(moc_any(), moc_any()),
+			moc_respond_1(moc_spy(&spy)));
+
+	ticks = 0;
+	assert(7 == add(3, 4L));
+	assert(8 == add(4, 4L));
+	/* Clock reads: call start, real start, real end, call end. */
+	assert(spy.realtime == 2 * 101);
+	assert(spy.moctime == 2 * 2);
+}
+
+struct moc_value fwd_sum(struct moc_call *call, struct moc_value data) {
+	int i, sum = 0;
+	if (sizeof(data)) {} /* unused warning */
+	for (i = 0; i < call->nparams; i++) {
+		sum += moc_get_i(call->params[i]);
+	}
+	return moc_i(sum);
+}
+
+void test_spy_many_params(void) {
+	char mem[2000];
+	struct moc_spy spy;
+	struct moc_matcher matchers[9];
+	struct moc_responder responder;
+	struct moc_value params[9];
+	int i;
+
+	moc_init(mem, sizeof(mem));
+	moc_init_spy(&spy, fwd_sum);
+	for (i = 0; i < 9; i++) {
+		matchers[i] = moc_any();
+		params[i] = moc_i(i + 1);
+	}
+	responder = moc_spy(&spy);
+	moc_given_v(MOC_FN(sum9), 9, matchers, 1, &responder);
+	assert(45 == moc_get_i(moc_act_v(MOC_FN(sum9), moc_type_i(),
+			9, params)));
+	/* Only the first parameters are stored: */
+	assert(spy.nparams == MOC_SPYMAXPARAMS);
+	assert(moc_get_i(spy.params[MOC_SPYMAXPARAMS - 1])
+			== MOC_SPYMAXPARAMS);
+}
+
+int main(void) {
+	test_spy();
+	test_spy_time();
+	test_spy_many_params();
+	return 0;
+}
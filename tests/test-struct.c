@@ -0,0 +1,184 @@
+/*
+   Mocito is a mocking library for writing unit tests of C code.
+   Copyright (C) 2025 Carlos Rica Espinosa <jasampler@gmail.com>
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software Foundation,
+   Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+*/
+
+
+
+/*
+ * Tests of the mocks receiving and returning structs by value.
+ */
+
+#include "mocito.h"
+#include <stdio.h>
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Create the default function to manage the mocking-related errors. */
+void moc_error(void) { fprintf(stderr, "%s\n", moc_errmsg()); exit(1); }
+
+/* Tags of the structs of the tests: */
+enum { TAG_RECT = 1, TAG_STATS };
+
+struct rect {
+	long x, y, w, h;
+};
+
+struct stats {
+	long count;
+	double mean, max;
+	char label[40];
+};
+
+struct stats rect_stats(struct rect r, int samples) {
+	struct stats s;
+	memset(&s, 0, sizeof(s));
+	MOC_GET_ST(moc_act(MOC_FN(rect_stats), moc_type_st(),
+			moc_values_2(MOC_ST(r, TAG_RECT), moc_i(samples))),
+			s, TAG_STATS);
+	return s;
+}
+
+static struct rect make_rect(long x, long y, long w, long h) {
+	struct rect r;
+	memset(&r, 0, sizeof(r));
+	r.x = x;
+	r.y = y;
+	r.w = w;
+	r.h = h;
+	return r;
+}
+
+static struct stats make_stats(long count, double mean, const char *label) {
+	struct stats s;
+	memset(&s, 0, sizeof(s));
+	s.count = count;
+	s.mean = mean;
+	s.max = mean * 2;
+	strcpy(s.label, label);
+	return s;
+}
+
+static void given_stats(void) {
+	struct rect r;
+	struct stats s;
+	/* The local structs are copied when adding the mappings: */
+	r = make_rect(0, 0, 10, 20);
+	s = make_stats(3, 1.5, "small");
+	moc_given(MOC_FN(rect_stats), moc_match_2(moc_eq(MOC_ST(r, TAG_RECT)),
+			moc_any()),
+			moc_respond_1(moc_return(MOC_ST(s, TAG_STATS))));
+	r = make_rect(0, 0, 0, 0);
+	s = make_stats(9, 4.5, "large");
+	moc_given(MOC_FN(rect_stats), moc_match_2(moc_gt(MOC_ST(r, TAG_RECT)),
+			moc_eq(moc_i(100))),
+			moc_respond_1(moc_return(MOC_ST(s, TAG_STATS))));
+	memset(&r, 0xFF, sizeof(r));
+	memset(&s, 0xFF, sizeof(s));
+}
+
+void test_struct(void) {
+	char mem[4000];
+	struct stats s;
+	moc_init(mem, sizeof(mem));
+	given_stats();
+	s = rect_stats(make_rect(0, 0, 10, 20), 1);
+	assert(s.count == 3 && s.mean == 1.5 && s.max == 3.0);
+	assert(strcmp(s.label, "small") == 0);
+	s = rect_stats(make_rect(5, 5, 1, 1), 100);
+	assert(s.count == 9 && s.mean == 4.5);
+	assert(strcmp(s.label, "large") == 0);
+}
+
+static int nerrors;
+
+static void count_error(void) {
+	nerrors++;
+}
+
+void test_struct_tag(void) {
+	char mem[4000];
+	struct stats s;
+	struct rect r;
+	moc_errfn_t errfn;
+	moc_init(mem, sizeof(mem));
+	given_stats();
+	s = make_stats(0, 0.0, "none");
+	errfn = moc_get_errfn();
+	moc_set_errfn(count_error);
+	nerrors = 0;
+	/* The structs of other size or tag are not copied: */
+	assert(! MOC_GET_ST(moc_i(1), r, TAG_RECT));
+	assert(! MOC_GET_ST(moc_st(&s, sizeof(s), TAG_RECT), s, TAG_STATS));
+	assert(! MOC_GET_ST(moc_st(&s, sizeof(s), TAG_STATS), r, TAG_RECT));
+	assert(nerrors == 2);
+	assert(strcmp(s.label, "none") == 0);
+	moc_set_errfn(errfn);
+}
+
+/* Returns another setup than given_stats for moc_reuse: */
+static void given_stats_again(void) {
+	given_stats();
+}
+
+void test_struct_reuse(void) {
+	char mem[4000];
+	struct stats s;
+	int i;
+	moc_init(mem, sizeof(mem));
+	/* The memory of the copied structs is freed by each setup: */
+	for (i = 0; i < 100; i++) {
+		moc_reuse(i % 2 == 0 ? given_stats : given_stats_again);
+	}
+	s = rect_stats(make_rect(0, 0, 10, 20), 1);
+	assert(s.count == 3);
+}
+
+struct moc_value fwd_stats(struct moc_call *call, struct moc_value data) {
+	static struct stats s;
+	if (sizeof(call) + sizeof(data)) {} /* unused warning */
+	s = make_stats(1, 2.0, "real");
+	return MOC_ST(s, TAG_STATS);
+}
+
+void test_struct_record(void) {
+	char mem[4000], trace[1000];
+	struct moc_spy spy;
+	struct moc_recorder rec;
+	struct stats s;
+	unsigned long len;
+	moc_init(mem, sizeof(mem));
+	moc_init_recorder(&rec, trace, sizeof(trace));
+	len = rec.len;
+	moc_init_spy(&spy, fwd_stats);
+	moc_spy_record(&spy, &rec, 0, 0);
+	moc_given(MOC_FN(rect_stats), moc_match_2(moc_any(), moc_any()),
+			moc_respond_1(moc_spy(&spy)));
+	/* The bytes of the structs are not recorded: */
+	s = rect_stats(make_rect(0, 0, 1, 1), 1);
+	assert(s.count == 1 && strcmp(s.label, "real") == 0);
+	assert(rec.len == len && rec.nlost == 1);
+}
+
+int main(void) {
+	test_struct();
+	test_struct_tag();
+	test_struct_reuse();
+	test_struct_record();
+	return 0;
+}
@@ -0,0 +1,100 @@
+/*
+   Mocito is a mocking library for writing unit tests of C code.
+   Copyright (C) 2025 Carlos Rica Espinosa <jasampler@gmail.com>
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software Foundation,
+   Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+*/
+
+/*
+ * Tests of mocks configured with static tables of mappings.
+ */
+
+#include "mocito.h"
+#include <stdio.h>
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Create the default function to manage the mocking-related errors. */
+void moc_error(void) { fprintf(stderr, "%s\n", moc_errmsg()); exit(1); }
+
+int ifun0(void) {
+	return moc_get_i(moc_act(MOC_FN(ifun0), moc_type_i(),
+			moc_values_0()));
+}
+
+int ifun2(char c, long l) {
+	return moc_get_i(moc_act(MOC_FN(ifun2), moc_type_i(),
+			moc_values_2(moc_c(c), moc_l(l))));
+}
+
+const char *strfun2(const char *str, double d) {
+	return moc_get_cp_c(moc_act(MOC_FN(strfun2), moc_type_cp_c(),
+			moc_values_2(moc_cp_c(str), moc_d(d))));
+}
+
+MOC_STATIC_GIVEN_TABLE(fixture) = {
+	MOC_TROW_0(ifun0, MOC_TRET_I(10)),
+	MOC_TROW_2(ifun2, MOC_TRET_I(1), MOC_TEQ_C('a'), MOC_TEQ_L(100L)),
+	MOC_TROW_2(ifun2, MOC_TRET_I(2), MOC_TEQ_C('a'), MOC_TANY),
+	MOC_TROW_2(ifun2, MOC_TRET_I(3), MOC_TANY, MOC_TANY),
+	MOC_TROW_2(strfun2, MOC_TRET_CP_C("pi"), MOC_TEQ_CSTR("x"),
+			MOC_TEQ_D(3.14)),
+	MOC_TROW_2(strfun2, MOC_TRET_CP_C("other"), MOC_TANY, MOC_TANY)
+};
+
+void test_table(void) {
+	char mem[2000];
+	char x[2];
+
+	moc_init(mem, sizeof(mem));
+	moc_attach_table(fixture, sizeof(fixture) / sizeof(fixture[0]));
+
+	x[0] = 'x';
+	x[1] = '\0';
+	assert(10 == ifun0());
+	assert(1 == ifun2('a', 100L));
+	assert(2 == ifun2('a', 200L));
+	assert(3 == ifun2('b', 100L));
+	assert(strcmp(strfun2(x, 3.14), "pi") == 0);
+	assert(strcmp(strfun2(x, 2.71), "other") == 0);
+	assert(strcmp(strfun2("y", 3.14), "other") == 0);
+}
+
+void test_table_defaults(void) {
+	char mem[2000];
+
+	moc_init(mem, sizeof(mem));
+	moc_attach_table(fixture, sizeof(fixture) / sizeof(fixture[0]));
+	moc_given(MOC_FN(ifun2),
+			moc_match_2(moc_eq(moc_c('b')), moc_any()),
+			moc_respond_1(moc_return(moc_i(-1))));
+
+	assert(-1 == ifun2('b', 100L));
+	assert(1 == ifun2('a', 100L));
+	assert(10 == ifun0());
+
+	moc_init(mem, sizeof(mem));
+	moc_given(MOC_FN(ifun0),
+			moc_match_0(),
+			moc_respond_1(moc_return(moc_i(20))));
+	assert(20 == ifun0());
+}
+
+int main(void) {
+	test_table();
+	test_table_defaults();
+	return 0;
+}
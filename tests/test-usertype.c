@@ -0,0 +1,155 @@
+/*
+   Mocito is a mocking library for writing unit tests of C code.
+   Copyright (C) 2025 Carlos Rica Espinosa <jasampler@gmail.com>
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software Foundation,
+   Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+*/
+
+
+
+/*
+ * Tests of the user types with comparison and hash functions.
+ */
+
+#include "mocito.h"
+#include <stdio.h>
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Create the default function to manage the mocking-related errors. */
+void moc_error(void) { fprintf(stderr, "%s\n", moc_errmsg()); exit(1); }
+
+/* Decimal number with a fixed number of digits after the point. */
+struct decimal {
+	long units;
+	long scale;
+};
+
+enum { TAG_DECIMAL = 1 };
+
+static struct decimal dec(long units, long scale) {
+	struct decimal d;
+	d.units = units;
+	d.scale = scale;
+	return d;
+}
+
+/* Returns the units of the decimal with 4 digits after the point. */
+static long dec4(const struct decimal *d) {
+	long u, s;
+	for (u = d->units, s = d->scale; s < 4; s++) {
+		u *= 10;
+	}
+	return u;
+}
+
+static int dec_cmp(const void *data1, const void *data2) {
+	long u1, u2;
+	u1 = dec4((const struct decimal *) data1);
+	u2 = dec4((const struct decimal *) data2);
+	return u1 < u2 ? -1 : u1 > u2 ? 1 : 0;
+}
+
+static unsigned long dec_hash(const void *data) {
+	return (unsigned long) dec4((const struct decimal *) data);
+}
+
+static const struct moc_usertype usertypes[] = {
+	MOC_USERTYPE(TAG_DECIMAL, struct decimal, &dec_cmp, &dec_hash)
+};
+
+int pay(struct decimal amount) {
+	return moc_get_i(moc_act(MOC_FN(pay), moc_type_i(),
+			moc_values_1(MOC_ST(amount, TAG_DECIMAL))));
+}
+
+static void given_pay(struct decimal d) {
+	moc_given(MOC_FN(pay), moc_match_1(moc_eq(MOC_ST(d, TAG_DECIMAL))),
+			moc_respond_1(moc_return(moc_i(1))));
+	d = dec(100, 0);
+	moc_given(MOC_FN(pay), moc_match_1(moc_ge(MOC_ST(d, TAG_DECIMAL))),
+			moc_respond_1(moc_return(moc_i(2))));
+	moc_given(MOC_FN(pay), moc_match_1(moc_any()),
+			moc_respond_1(moc_return(moc_i(0))));
+}
+
+void test_usertype(void) {
+	char mem[4000];
+	unsigned long fp;
+	moc_init(mem, sizeof(mem));
+	moc_set_usertypes(usertypes, 1);
+	given_pay(dec(15, 1));
+	/* The values are compared with the function of their type: */
+	assert(pay(dec(15, 1)) == 1);
+	assert(pay(dec(150, 2)) == 1);
+	assert(pay(dec(1500, 3)) == 1);
+	assert(pay(dec(151, 2)) == 0);
+	assert(pay(dec(9999, 2)) == 0);
+	assert(pay(dec(10000, 2)) == 2);
+	assert(pay(dec(101, 0)) == 2);
+	fp = moc_fingerprint();
+
+	/* The equal values have equal hashes in the fingerprint: */
+	moc_init(mem, sizeof(mem));
+	moc_set_usertypes(usertypes, 1);
+	given_pay(dec(150, 2));
+	assert(moc_fingerprint() == fp);
+	moc_init(mem, sizeof(mem));
+	moc_set_usertypes(usertypes, 1);
+	given_pay(dec(16, 1));
+	assert(moc_fingerprint() != fp);
+}
+
+void test_usertype_unset(void) {
+	char mem[4000];
+	moc_init(mem, sizeof(mem));
+	given_pay(dec(15, 1));
+	/* Without the user type the values are compared by their bytes: */
+	assert(pay(dec(15, 1)) == 1);
+	assert(pay(dec(150, 2)) != 1);
+}
+
+static char lasterr[200];
+
+static void keep_error(void) {
+	strncpy(lasterr, moc_errmsg(), sizeof(lasterr) - 1);
+}
+
+void test_usertype_name(void) {
+	char mem[4000];
+	struct decimal d;
+	long l;
+	moc_errfn_t errfn;
+	moc_init(mem, sizeof(mem));
+	moc_set_usertypes(usertypes, 1);
+	errfn = moc_get_errfn();
+	moc_set_errfn(keep_error);
+	/* The errors name the expected struct: */
+	l = 0;
+	d = dec(1, 0);
+	assert(! MOC_GET_ST(MOC_ST(l, 2), d, TAG_DECIMAL));
+	assert(strstr(lasterr, "struct decimal") != 0);
+	assert(! MOC_GET_ST(MOC_ST(d, TAG_DECIMAL), l, 2));
+	assert(strstr(lasterr, "moc_get_st") != 0);
+	moc_set_errfn(errfn);
+}
+
+int main(void) {
+	test_usertype();
+	test_usertype_unset();
+	test_usertype_name();
+	return 0;
+}
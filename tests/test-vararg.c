@@ -0,0 +1,162 @@
+/*
+   Mocito is a mocking library for writing unit tests of C code.
+   Copyright (C) 2025 Carlos Rica Espinosa <jasampler@gmail.com>
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software Foundation,
+   Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+*/
+
+
+
+/*
+ * Tests of the mocks of variadic functions receiving a va_list.
+ */
+
+#include "mocito.h"
+#include <stdio.h>
+#include <assert.h>
+#include <stdlib.h>
+#include <stdarg.h>
+
+/* Create the default function to manage the mocking-related errors. */
+void moc_error(void) { fprintf(stderr, "%s\n", moc_errmsg()); exit(1); }
+
+int log_printf(int level, const char *format, ...) {
+	struct moc_value fixed[1];
+	va_list ap;
+	int r;
+	fixed[0] = moc_i(level);
+	va_start(ap, format);
+	r = moc_get_i(moc_act_fmt(MOC_FN(log_printf), moc_type_i(),
+			1, fixed, format, ap));
+	va_end(ap);
+	return r;
+}
+
+#define DEV_RESET 1
+#define DEV_SETRATE 2
+
+int dev_ioctl(int fd, unsigned long request, ...) {
+	static const moc_type ratetypes[] = { MOC_TYPE_UL, MOC_TYPE_P_I };
+	struct moc_value fixed[2];
+	va_list ap;
+	int r;
+	fixed[0] = moc_i(fd);
+	fixed[1] = moc_ul(request);
+	va_start(ap, request);
+	r = moc_get_i(moc_act_va(MOC_FN(dev_ioctl), moc_type_i(), 2, fixed,
+			request == DEV_SETRATE ? 2 : 0, ratetypes, ap));
+	va_end(ap);
+	return r;
+}
+
+void test_format(void) {
+	char mem[4000];
+	int ncalls = 0;
+	moc_init(mem, sizeof(mem));
+	moc_given(MOC_FN(log_printf), moc_match_7(moc_eq(moc_i(1)), moc_any(),
+			moc_eq_cstr("rate"), moc_any(), moc_any(),
+			moc_eq(moc_i(2)), moc_gt(moc_d(0.5))),
+			moc_respond_2(moc_count(moc_p_i(&ncalls)),
+				moc_return(moc_i(8))));
+	moc_given(MOC_FN(log_printf), moc_match_7(moc_any(), moc_any(),
+			moc_any(), moc_eq(moc_c('y')), moc_any(), moc_any(),
+			moc_any()),
+			moc_respond_1(moc_return(moc_i(0))));
+	moc_given(MOC_FN(log_printf), moc_match_3(moc_any(), moc_any(),
+			moc_eq(moc_ul(7))),
+			moc_respond_1(moc_return(moc_i(3))));
+	moc_given(MOC_FN(log_printf), moc_match_2(moc_any(), moc_any()),
+			moc_respond_1(moc_return(moc_i(0))));
+	assert(log_printf(1, "%s: %c%5d %-.*f%%\n",
+			"rate", 'x', 10, 2, 0.75) == 8);
+	assert(ncalls == 1);
+	/* The format is parsed only once for the same pointer: */
+	assert(log_printf(1, "%s: %c%5d %-.*f%%\n",
+			"rate", 'y', 20, 2, 0.25) == 0);
+	assert(log_printf(1, "%s: %c%5d %-.*f%%\n",
+			"rate", 'z', 30, 2, 1.5) == 8);
+	assert(ncalls == 2);
+	assert(log_printf(2, "%lu\n", 7UL) == 3);
+	assert(log_printf(2, "done\n") == 0);
+}
+
+void test_format_length(void) {
+	char mem[4000];
+	short written;
+	char cwritten;
+	moc_init(mem, sizeof(mem));
+	/* The pointers of %hn and %hhn have the types of their lengths: */
+	moc_given(MOC_FN(log_printf), moc_match_5(moc_any(), moc_any(),
+			moc_eq(moc_p_s(&written)), moc_eq(moc_p_c(&cwritten)),
+			moc_any()),
+			moc_respond_1(moc_return(moc_i(5))));
+	assert(log_printf(1, "%hn%hhn%hd", &written, &cwritten, 3) == 5);
+}
+
+static int nerrors;
+
+static void count_error(void) {
+	nerrors++;
+}
+
+void test_format_invalid(void) {
+	char mem[4000];
+	moc_errfn_t errfn;
+	moc_init(mem, sizeof(mem));
+	moc_given(MOC_FN(log_printf), moc_match_2(moc_any(), moc_any()),
+			moc_respond_1(moc_return(moc_i(0))));
+	/* The conversions of unsupported types are errors: */
+	errfn = moc_get_errfn();
+	moc_set_errfn(count_error);
+	nerrors = 0;
+	log_printf(0, "%Lf\n", 1.0);
+	assert(nerrors == 1);
+	moc_set_errfn(errfn);
+}
+
+static struct moc_value set_int(struct moc_value param,
+		struct moc_value val) {
+	*moc_get_p_i(param) = moc_get_i(val);
+	return val;
+}
+
+void test_ioctl(void) {
+	char mem[4000];
+	int rate = 0;
+	moc_init(mem, sizeof(mem));
+	moc_given(MOC_FN(dev_ioctl), moc_match_2(moc_eq(moc_i(3)),
+			moc_eq(moc_ul(DEV_RESET))),
+			moc_respond_1(moc_return(moc_i(0))));
+	moc_given(MOC_FN(dev_ioctl), moc_match_4(moc_eq(moc_i(3)),
+			moc_eq(moc_ul(DEV_SETRATE)), moc_lt(moc_ul(9600UL)),
+			moc_any()),
+			moc_respond_2(moc_rparam_nochk(4, &set_int, moc_i(4800)),
+				moc_return(moc_i(0))));
+	moc_given(MOC_FN(dev_ioctl), moc_match_4(moc_any(), moc_any(),
+			moc_any(), moc_any()),
+			moc_respond_1(moc_return(moc_i(-1))));
+	assert(dev_ioctl(3, DEV_RESET) == 0);
+	assert(dev_ioctl(3, DEV_SETRATE, 2400UL, &rate) == 0);
+	assert(rate == 4800);
+	assert(dev_ioctl(3, DEV_SETRATE, 19200UL, &rate) == -1);
+}
+
+int main(void) {
+	test_format();
+	test_format_length();
+	test_format_invalid();
+	test_ioctl();
+	return 0;
+}
@@ -0,0 +1,831 @@
+/*
+   Mocito is a mocking library for writing unit tests of C code.
+   Copyright (C) 2025 Carlos Rica Espinosa <jasampler@gmail.com>
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software Foundation,
+   Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+*/
+
+/*
+ * Generator of mocked functions for the prototypes of C headers.
+ *
+ * Usage: mocgen [-w | -f | -v] [header.h ...] > mocks.c
+ *
+ * Reads the given headers, or the standard input if none is given,
+ * and writes to the standard output a mock for each function prototype
+ * found, calling to moc_act_h with a static handle of the function.
+ * Prototypes with types that cannot be mocked are written as comments.
+ *
+ * With -w, writes __wrap_ functions instead of mocks for linking the
+ * code to be tested with -Wl,--wrap=function, which call to the real
+ * function while the mock has no mappings, and moc_real_ functions for
+ * spying the real functions with moc_spy. With -f, writes only those
+ * linker flags for the functions that can be wrapped.
+ *
+ * With -v, writes instead a mock vtable moc_T for each struct T whose
+ * members are all pointers to functions, with static functions for the
+ * members calling to moc_act_self with their first parameter, if it is
+ * a pointer, as the instance. Their mappings use names like "T.member".
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+#define MAXTOKS 256
+#define MAXTOKLEN 64
+#define MAXTYPETOKS 16
+#define MAXTYPELEN (MAXTYPETOKS * MAXTOKLEN)
+#define MAXPARAMS 32
+#define MAXGRPPARAMS 7 /* parameters passed with moc_values_N */
+#define MAXSLOTS 64 /* members of the structs of function pointers */
+
+/* Mocito type of a parameter or return value of a prototype. */
+struct mtype {
+	char text[MAXTYPELEN]; /* C type as it must be written */
+	char suffix[8]; /* suffix of moc_X, moc_get_X and MOC_TYPE_X */
+	int cast; /* if the value must be converted with casts */
+	int isconst; /* if the generic pointer points to const data */
+};
+
+/* Parameter of a prototype. */
+struct param {
+	struct mtype type;
+	char name[MAXTOKLEN];
+	char decl[MAXTYPELEN + MAXTOKLEN]; /* declaration with the name */
+};
+
+static char toks[MAXTOKS][MAXTOKLEN];
+static int ntoks;
+
+/* Reads the whole file in a buffer allocated with malloc. */
+static char *readall(FILE *fp) {
+	char *buf, *nbuf;
+	size_t len, size, n;
+	size = 4096;
+	len = 0;
+	buf = malloc(size);
+	while (buf != NULL && (n = fread(buf + len, 1, size - len - 1, fp)) > 0) {
+		len += n;
+		if (size - len - 1 == 0) {
+			size *= 2;
+			nbuf = realloc(buf, size);
+			if (nbuf == NULL) {
+				free(buf);
+			}
+			buf = nbuf;
+		}
+	}
+	if (buf != NULL) {
+		buf[len] = '\0';
+	}
+	return buf;
+}
+
+/* Replaces the comments, string literals and preprocessor lines with
+ * spaces, preserving the quotes of the strings. */
+static void blankout(char *s) {
+	int bol = 1;
+	while (*s != '\0') {
+		if (s[0] == '/' && s[1] == '*') {
+			*s++ = ' ';
+			*s++ = ' ';
+			while (*s != '\0' && ! (s[0] == '*' && s[1] == '/')) {
+				*s++ = ' ';
+			}
+			if (*s != '\0') {
+				*s++ = ' ';
+				*s++ = ' ';
+			}
+		} else if (s[0] == '/' && s[1] == '/') {
+			while (*s != '\0' && *s != '\n') {
+				*s++ = ' ';
+			}
+		} else if (*s == '"' || *s == '\'') {
+			char q = *s++;
+			while (*s != '\0' && *s != q && *s != '\n') {
+				if (*s == '\\' && s[1] != '\0') {
+					*s++ = ' ';
+				}
+				*s++ = ' ';
+			}
+			if (*s == q) {
+				s++;
+			}
+			bol = 0;
+		} else if (bol && *s == '#') {
+			while (*s != '\0' && *s != '\n') {
+				if (*s == '\\' && s[1] == '\n') {
+					*s++ = ' ';
+				}
+				*s++ = ' ';
+			}
+		} else {
+			if (*s == '\n') {
+				bol = 1;
+			} else if (! isspace((unsigned char) *s)) {
+				bol = 0;
+			}
+			s++;
+		}
+	}
+}
+
+/* Splits the declaration in tokens, returning 0 if there are too many. */
+static int tokenize(const char *s, const char *end) {
+	int n;
+	ntoks = 0;
+	while (s < end) {
+		if (isspace((unsigned char) *s)) {
+			s++;
+			continue;
+		}
+		if (ntoks == MAXTOKS) {
+			return 0;
+		}
+		n = 1;
+		if (isalpha((unsigned char) *s) || *s == '_') {
+			while (s + n < end && (isalnum((unsigned char) s[n])
+					|| s[n] == '_')) {
+				n++;
+			}
+		} else if (end - s >= 3 && strncmp(s, "...", 3) == 0) {
+			n = 3;
+		}
+		if (n >= MAXTOKLEN) {
+			return 0;
+		}
+		memcpy(toks[ntoks], s, n);
+		toks[ntoks][n] = '\0';
+		ntoks++;
+		s += n;
+	}
+	return 1;
+}
+
+static int isident(const char *tok) {
+	return isalpha((unsigned char) tok[0]) || tok[0] == '_';
+}
+
+static int iskeyword(const char *tok) {
+	static const char *const kws[] = { "const", "volatile", "restrict",
+		"register", "signed", "unsigned", "char", "short", "int",
+		"long", "float", "double", "void", "struct", "union", "enum",
+		NULL };
+	int i;
+	for (i = 0; kws[i] != NULL; i++) {
+		if (strcmp(tok, kws[i]) == 0) {
+			return 1;
+		}
+	}
+	return 0;
+}
+
+/* Writes the tokens from first to last (excluded) but skipping the
+ * token in the position skip, separated by spaces only where needed. */
+static void jointoks(int first, int last, int skip, char *out) {
+	int i;
+	out[0] = '\0';
+	for (i = first; i < last; i++) {
+		if (i == skip) {
+			continue;
+		}
+		if (out[0] != '\0' && isident(toks[i - (i - 1 == skip ? 2 : 1)])
+				&& (isident(toks[i]) || toks[i][0] == '*')) {
+			strcat(out, " ");
+		}
+		strcat(out, toks[i]);
+	}
+}
+
+/* Returns the suffix of a basic type given by its words, or NULL. */
+static const char *basicsuffix(const char *words) {
+	static const char *const types[] = {
+		"void", "void", "char", "c", "signed char", "sc",
+		"unsigned char", "uc", "short", "s", "short int", "s",
+		"signed short", "s", "signed short int", "s",
+		"unsigned short", "us", "unsigned short int", "us",
+		"int", "i", "signed", "i", "signed int", "i",
+		"unsigned", "ui", "unsigned int", "ui",
+		"long", "l", "long int", "l", "signed long", "l",
+		"signed long int", "l", "unsigned long", "ul",
+		"unsigned long int", "ul", "float", "f", "double", "d",
+		NULL };
+	int i;
+	for (i = 0; types[i] != NULL; i += 2) {
+		if (strcmp(words, types[i]) == 0) {
+			return types[i + 1];
+		}
+	}
+	return NULL;
+}
+
+/* Classifies the type given by the tokens from first to last (excluded)
+ * skipping the token of the name, returning 0 if it is not supported. */
+static int classify(int first, int last, int skip, struct mtype *mt) {
+	char words[MAXTYPELEN];
+	const char *suffix;
+	char *q;
+	int i, nptrs = 0, lastptr = -1, prevptr = -1, constpointee = 0;
+	if (last - first > MAXTYPETOKS) {
+		return 0;
+	}
+	words[0] = '\0';
+	for (i = first; i < last; i++) {
+		if (i == skip) {
+			continue;
+		}
+		if (strcmp(toks[i], "*") == 0 || strcmp(toks[i], "[") == 0) {
+			nptrs++;
+			prevptr = lastptr;
+			lastptr = i;
+			if (toks[i][0] == '[') {
+				while (i < last && strcmp(toks[i], "]") != 0) {
+					i++;
+				}
+			}
+		} else if (! isident(toks[i])) {
+			return 0;
+		} else if (nptrs == 0 && strcmp(toks[i], "const") != 0
+				&& strcmp(toks[i], "volatile") != 0
+				&& strcmp(toks[i], "register") != 0) {
+			if (words[0] != '\0') {
+				strcat(words, " ");
+			}
+			strcat(words, toks[i]);
+		}
+	}
+	if (words[0] == '\0') {
+		return 0;
+	}
+	for (i = (nptrs > 1 ? prevptr : first); i < lastptr; i++) {
+		if (strcmp(toks[i], "const") == 0) {
+			constpointee = 1;
+		}
+	}
+	jointoks(first, last, skip, mt->text);
+	/* The arrays are written as pointers for the casts: */
+	if ((q = strchr(mt->text, '[')) != NULL) {
+		*q = ' ';
+		q[1] = '\0';
+		for (i = first; i < last; i++) {
+			if (toks[i][0] == '[') {
+				strcat(mt->text, "*");
+			}
+		}
+	}
+	mt->isconst = constpointee;
+	mt->cast = 0;
+	suffix = basicsuffix(words);
+	if (suffix == NULL && nptrs == 0 && strncmp(words, "enum ", 5) == 0) {
+		/* The enumerations are passed as int values with casts: */
+		suffix = "i";
+		mt->cast = 1;
+	}
+	if (nptrs == 0) {
+		if (suffix == NULL || (strcmp(suffix, "void") == 0
+				&& last - first > 1)) {
+			return 0;
+		}
+		strcpy(mt->suffix, suffix);
+	} else if (nptrs == 1 && suffix != NULL) {
+		strcpy(mt->suffix, constpointee ? "cp" : "p");
+		if (strcmp(suffix, "void") != 0) {
+			strcat(mt->suffix, "_");
+			strcat(mt->suffix, suffix);
+		}
+	} else {
+		/* Other pointers are passed as generic pointers with casts: */
+		strcpy(mt->suffix, constpointee ? "cp" : "p");
+		mt->cast = 1;
+	}
+	return 1;
+}
+
+/* Output column used for wrapping the long lines. */
+static int col;
+
+/* Output mode: 'm' for mocks, 'w' for linker wrappers, 'f' for flags,
+ * 'v' for vtables. */
+static int mode = 'm';
+static int nflags;
+
+static void out(const char *str) {
+	for (; *str != '\0'; str++) {
+		putchar(*str);
+		col = *str == '\n' ? 0 : *str == '\t' ? (col / 8 + 1) * 8 : col + 1;
+	}
+}
+
+/* Writes the text after a space, or in a new line with the indent
+ * if it does not fit, unless it is the first text of a list. */
+static void outwrap(const char *str, int first, const char *indent) {
+	if (col + 1 + strlen(str) > 79) {
+		out("\n");
+		out(indent);
+	} else if (! first) {
+		out(" ");
+	}
+	out(str);
+}
+
+/* Writes the constant MOC_TYPE_X of the type with the given suffix. */
+static void outtype(const char *suffix) {
+	char buf[sizeof("MOC_TYPE_") + 8];
+	int i;
+	strcpy(buf, "MOC_TYPE_");
+	for (i = 0; suffix[i] != '\0'; i++) {
+		buf[9 + i] = (char) toupper((unsigned char) suffix[i]);
+	}
+	buf[9 + i] = '\0';
+	out(buf);
+}
+
+/* Writes the prototype of the function with the prefix in its name. */
+static void writeproto(const char *prefix, const char *name,
+		struct mtype *ret, struct param *params, int nparams) {
+	char buf[MAXTYPELEN + MAXTOKLEN];
+	int i;
+	out(ret->text);
+	if (ret->text[strlen(ret->text) - 1] != '*') {
+		out(" ");
+	}
+	out(prefix);
+	out(name);
+	out("(");
+	for (i = 0; i < nparams; i++) {
+		sprintf(buf, "%s%s", params[i].decl, i + 1 < nparams ? "," : "");
+		outwrap(buf, i == 0, "\t\t");
+	}
+	out(nparams == 0 ? "void)" : ")");
+}
+
+/* Writes the function that forwards the calls to the real function,
+ * to be used with moc_init_spy. */
+static void writereal(const char *name, struct mtype *ret,
+		struct param *params, int nparams) {
+	char buf[MAXTYPELEN + 3 * MAXTOKLEN];
+	int i, isvoid;
+	isvoid = strcmp(ret->suffix, "void") == 0;
+	sprintf(buf, "struct moc_value moc_real_%s(struct moc_call *call,\n"
+			"\t\tstruct moc_value data) {\n", name);
+	out(buf);
+	out(nparams == 0 ? "\tif (sizeof(call)) {} /* unused warning */\n"
+			: "");
+	out("\tif (sizeof(data)) {} /* unused warning */\n\t");
+	if (! isvoid) {
+		sprintf(buf, "return moc_%s(%s", ret->suffix,
+			! ret->cast ? "" : ret->suffix[0] == 'i' ? "(int) "
+			: ret->isconst ? "(const void *) " : "(void *) ");
+		out(buf);
+	}
+	sprintf(buf, "__real_%s(", name);
+	out(buf);
+	for (i = 0; i < nparams; i++) {
+		buf[0] = '\0';
+		if (params[i].type.cast) {
+			strcat(buf, "(");
+			strcat(buf, params[i].type.text);
+			strcat(buf, ") ");
+		}
+		sprintf(buf + strlen(buf), "moc_get_%s(call->params[%d])%s",
+				params[i].type.suffix, i,
+				i + 1 < nparams ? "," : isvoid ? ");" : "));");
+		outwrap(buf, i == 0, "\t\t\t");
+	}
+	if (nparams == 0) {
+		out(isvoid ? ");" : "));");
+	}
+	out(isvoid ? "\n\treturn moc_void();\n}\n\n" : "\n}\n\n");
+}
+
+/* Writes the mock of the function with the given return and parameters,
+ * or its linker wrapper calling to the real function when the mock has
+ * no mappings, or the static function of a member of a vtable. */
+static void writemock(const char *name, const char *hndname,
+		struct mtype *ret, struct param *params, int nparams) {
+	char buf[MAXTYPELEN + 3 * MAXTOKLEN];
+	int i, isarray;
+	isarray = nparams > MAXGRPPARAMS;
+	if (mode == 'v') {
+		out("static ");
+		writeproto("", name, ret, params, nparams);
+	} else if (mode == 'w') {
+		writeproto("__real_", name, ret, params, nparams);
+		out(";\n\n");
+		writereal(name, ret, params, nparams);
+		writeproto("__wrap_", name, ret, params, nparams);
+	} else {
+		writeproto("", name, ret, params, nparams);
+	}
+	out(" {\n");
+	out("\tstatic struct moc_handle moc_hnd = MOC_HANDLE(");
+	out(hndname);
+	out(");\n\t");
+	if (isarray) {
+		sprintf(buf, "struct moc_value moc_params[%d];\n\t", nparams);
+		out(buf);
+	}
+	if (mode == 'w') {
+		sprintf(buf, "if (! moc_has_mappings(&moc_hnd, %d)) {\n\t\t%s__real_%s(",
+				nparams, strcmp(ret->suffix, "void") != 0
+				? "return " : "", name);
+		out(buf);
+		for (i = 0; i < nparams; i++) {
+			sprintf(buf, "%s%s", params[i].name,
+					i + 1 < nparams ? "," : "");
+			outwrap(buf, i == 0, "\t\t\t\t");
+		}
+		out(strcmp(ret->suffix, "void") != 0 ? ");\n\t}\n\t"
+				: ");\n\t\treturn;\n\t}\n\t");
+	}
+	/* The parameters that do not fit in moc_values_N use an array: */
+	for (i = 0; isarray && i < nparams; i++) {
+		sprintf(buf, "moc_params[%d] = moc_%s(%s%s);\n\t", i,
+			params[i].type.suffix,
+			! params[i].type.cast ? ""
+			: params[i].type.suffix[0] == 'i' ? "(int) "
+			: params[i].type.isconst ? "(const void *) " : "(void *) ",
+			params[i].name);
+		out(buf);
+	}
+	if (strcmp(ret->suffix, "void") != 0) {
+		out("return ");
+		if (ret->cast) {
+			sprintf(buf, "(%s) ", ret->text);
+			out(buf);
+		}
+		sprintf(buf, "moc_get_%s(", ret->suffix);
+		out(buf);
+	}
+	if (mode == 'v') {
+		/* The first parameter is the instance if it is a pointer: */
+		sprintf(buf, "moc_act_self(&moc_hnd,\n\t\t\t%s%s, ",
+				nparams > 0 && strchr(params[0].type.suffix, 'p')
+				!= NULL ? "(const void *) " : "",
+				nparams > 0 && strchr(params[0].type.suffix, 'p')
+				!= NULL ? params[0].name : "0");
+	} else {
+		strcpy(buf, "moc_act_h(&moc_hnd, ");
+	}
+	out(buf);
+	/* The return type is a constant without calls to the library: */
+	outtype(ret->suffix);
+	out(",\n");
+	if (isarray) {
+		sprintf(buf, "\t\t\tmoc_init_values_grp(%d, moc_params)%s",
+				nparams, strcmp(ret->suffix, "void") != 0
+				? "));" : ");");
+		out(buf);
+		nparams = -1;
+	} else {
+		sprintf(buf, "\t\t\tmoc_values_%d(", nparams);
+		out(buf);
+	}
+	for (i = 0; i < nparams; i++) {
+		sprintf(buf, "moc_%s(%s%s)%s", params[i].type.suffix,
+			! params[i].type.cast ? ""
+			: params[i].type.suffix[0] == 'i' ? "(int) "
+			: params[i].type.isconst ? "(const void *) " : "(void *) ",
+			params[i].name, i + 1 < nparams ? ","
+			: strcmp(ret->suffix, "void") != 0 ? ")));" : "));");
+		outwrap(buf, i == 0, "\t\t\t\t\t");
+	}
+	if (nparams == 0) {
+		out(strcmp(ret->suffix, "void") != 0 ? ")));" : "));");
+	}
+	out("\n");
+	out("}\n\n");
+}
+
+/* Names of the functions already written, to skip repeated prototypes. */
+static char **names;
+static int nnames, maxnames;
+
+static int addname(const char *name) {
+	char **nnamesp;
+	int i;
+	for (i = 0; i < nnames; i++) {
+		if (strcmp(names[i], name) == 0) {
+			return 0;
+		}
+	}
+	if (nnames == maxnames) {
+		maxnames = maxnames == 0 ? 64 : maxnames * 2;
+		nnamesp = realloc(names, maxnames * sizeof(char *));
+		if (nnamesp == NULL) {
+			fprintf(stderr, "mocgen: out of memory\n");
+			exit(1);
+		}
+		names = nnamesp;
+	}
+	names[nnames] = malloc(strlen(name) + 1);
+	if (names[nnames] == NULL) {
+		fprintf(stderr, "mocgen: out of memory\n");
+		exit(1);
+	}
+	strcpy(names[nnames++], name);
+	return 1;
+}
+
+/* Parses the tokens of a parameter from first to last (excluded). */
+static int parseparam(int first, int last, int pos, struct param *prm) {
+	int i, end, skip = -1;
+	for (end = first; end < last && toks[end][0] != '['; end++) {
+		if (toks[end][0] == '(' || strcmp(toks[end], "...") == 0) {
+			return 0;
+		}
+	}
+	i = end - 1;
+	if (i > first && isident(toks[i]) && ! iskeyword(toks[i])
+			&& strcmp(toks[i - 1], "struct") != 0
+			&& strcmp(toks[i - 1], "union") != 0
+			&& strcmp(toks[i - 1], "enum") != 0) {
+		skip = i;
+		strcpy(prm->name, toks[i]);
+	} else if (end < last) {
+		return 0; /* unnamed arrays are not supported */
+	} else {
+		sprintf(prm->name, "p%d", pos);
+	}
+	if (! classify(first, last, skip, &(prm->type))
+			|| strcmp(prm->type.suffix, "void") == 0) {
+		return 0;
+	}
+	jointoks(first, last, -1, prm->decl);
+	if (skip < 0) {
+		strcat(prm->decl, " ");
+		strcat(prm->decl, prm->name);
+	}
+	return 1;
+}
+
+/* Parses the parameters of a prototype from the token after its opening
+ * parenthesis, that must be closed by the last token, and returns their
+ * number or -1 if they cannot be mocked. */
+static int parseparams(int first, struct param *params) {
+	int i, cp, depth = 0, nparams = 0, ok = 1;
+	for (cp = first, i = first; ok && cp < ntoks; cp++) {
+		if (toks[cp][0] == '(') {
+			depth++;
+		} else if (toks[cp][0] == ')' && depth > 0) {
+			depth--;
+		} else if ((toks[cp][0] == ',' || toks[cp][0] == ')')
+				&& depth == 0) {
+			if (toks[cp][0] == ')' && nparams == 0 && (cp == i
+					|| (cp == i + 1
+					&& strcmp(toks[i], "void") == 0))) {
+				break; /* without parameters */
+			}
+			ok = nparams < MAXPARAMS && parseparam(i, cp,
+					nparams + 1, params + nparams);
+			nparams++;
+			i = cp + 1;
+			if (toks[cp][0] == ')') {
+				break;
+			}
+		}
+	}
+	return ok && cp == ntoks - 1 ? nparams : -1;
+}
+
+/* Parses a declaration and writes its mock if it is a function. */
+static void parsedecl(const char *start, const char *end) {
+	struct param params[MAXPARAMS];
+	struct mtype ret;
+	char name[MAXTOKLEN];
+	int i, b, op, nparams;
+	if (mode == 'v' || ! tokenize(start, end)) {
+		return;
+	}
+	for (i = 0; i < ntoks; i++) {
+		if (strcmp(toks[i], "typedef") == 0) {
+			return;
+		}
+	}
+	for (b = 0; b < ntoks && (strcmp(toks[b], "extern") == 0
+			|| strcmp(toks[b], "static") == 0
+			|| strcmp(toks[b], "inline") == 0); b++) {
+		;
+	}
+	for (op = b; op < ntoks && toks[op][0] != '('; op++) {
+		;
+	}
+	if (op == ntoks || op - 1 <= b || ! isident(toks[op - 1])
+			|| iskeyword(toks[op - 1])
+			|| (op + 1 < ntoks && toks[op + 1][0] == '*')) {
+		return; /* not a function prototype */
+	}
+	strcpy(name, toks[op - 1]);
+	if (! addname(name)) {
+		return;
+	}
+	nparams = classify(b, op - 1, -1, &ret)
+		? parseparams(op + 1, params) : -1;
+	if (nparams < 0) {
+		if (mode != 'f') {
+			out("/* Not supported: ");
+			out(name);
+			out(" */\n\n");
+		}
+		return;
+	}
+	if (mode == 'f') {
+		out(nflags++ > 0 ? " -Wl,--wrap=" : "-Wl,--wrap=");
+		out(name);
+	} else {
+		writemock(name, name, &ret, params, nparams);
+	}
+}
+
+/* Parses a member of a struct from start to end (excluded) that must be
+ * a pointer to a function, returning its number of parameters or -1. */
+static int parseslot(const char *start, const char *end, char *name,
+		struct mtype *ret, struct param *params) {
+	int op;
+	if (! tokenize(start, end)) {
+		return -1;
+	}
+	for (op = 0; op < ntoks && toks[op][0] != '('; op++) {
+		;
+	}
+	if (op == 0 || op + 4 >= ntoks || toks[op + 1][0] != '*'
+			|| ! isident(toks[op + 2]) || toks[op + 3][0] != ')'
+			|| toks[op + 4][0] != '(') {
+		return -1;
+	}
+	strcpy(name, toks[op + 2]);
+	return classify(0, op, -1, ret) ? parseparams(op + 5, params) : -1;
+}
+
+/* Parses the definition of a struct, with its members between the
+ * braces, and writes its mock vtable if they are all pointers to
+ * functions that can be mocked. */
+static void parsestruct(const char *start, const char *open,
+		const char *close) {
+	struct param params[MAXPARAMS];
+	struct mtype ret;
+	char tag[MAXTOKLEN], slot[MAXTOKLEN], slots[MAXSLOTS][MAXTOKLEN];
+	char name[2 * MAXTOKLEN + 1], hndname[2 * MAXTOKLEN + 1];
+	char buf[MAXTYPELEN];
+	const char *p, *q;
+	int i, nparams, nslots = 0, ok = 1;
+	if (! tokenize(start, open) || ntoks < 2
+			|| strcmp(toks[ntoks - 2], "struct") != 0
+			|| ! isident(toks[ntoks - 1])) {
+		return;
+	}
+	strcpy(tag, toks[ntoks - 1]);
+	if (! addname(tag)) {
+		return;
+	}
+	/* Checks all the members before writing the functions: */
+	for (p = q = open + 1; ok && p < close; p++) {
+		if (*p == '{') {
+			ok = 0;
+		} else if (*p == ';') {
+			ok = nslots < MAXSLOTS && parseslot(q, p,
+					slots[nslots++], &ret, params) >= 0;
+			q = p + 1;
+		}
+	}
+	if (! ok || nslots == 0) {
+		out("/* Not supported: struct ");
+		out(tag);
+		out(" */\n\n");
+		return;
+	}
+	for (p = q = open + 1; p < close; p++) {
+		if (*p == ';') {
+			nparams = parseslot(q, p, slot, &ret, params);
+			sprintf(name, "%s_%s", tag, slot);
+			sprintf(hndname, "%s.%s", tag, slot);
+			writemock(name, hndname, &ret, params, nparams);
+			q = p + 1;
+		}
+	}
+	sprintf(buf, "const struct %s moc_%s = {\n", tag, tag);
+	out(buf);
+	for (i = 0; i < nslots; i++) {
+		out("\t");
+		out(tag);
+		out("_");
+		out(slots[i]);
+		out(i + 1 < nslots ? ",\n" : "\n");
+	}
+	out("};\n\n");
+}
+
+/* Returns if the text is the beginning of an extern "C" block. */
+static int isexternc(const char *start, const char *end) {
+	return tokenize(start, end) && ntoks == 3
+		&& strcmp(toks[0], "extern") == 0;
+}
+
+/* Finds the declarations of the text ignoring the bodies of the
+ * functions and the declarations with braces, like struct types. */
+static void scan(const char *s) {
+	const char *start, *open = NULL, *p, *q;
+	int depth = 0, body = 0, isfunc = 0;
+	start = s;
+	for (p = s; *p != '\0'; p++) {
+		if (*p == '{') {
+			if (depth == 0 && isexternc(start, p)) {
+				start = p + 1;
+				continue;
+			}
+			if (depth++ == 0) {
+				for (q = p; q > start
+					&& isspace((unsigned char) q[-1]); q--) {
+					;
+				}
+				isfunc = q > start && q[-1] == ')';
+				body = 1;
+				open = p;
+			}
+		} else if (*p == '}') {
+			if (depth == 0) {
+				start = p + 1; /* end of an extern "C" block */
+			} else if (--depth == 0 && isfunc) {
+				start = p + 1;
+				body = 0;
+			} else if (depth == 0 && mode == 'v') {
+				parsestruct(start, open, p);
+			}
+		} else if (*p == ';' && depth == 0) {
+			if (! body) {
+				parsedecl(start, p);
+			}
+			start = p + 1;
+			body = 0;
+		}
+	}
+}
+
+static char *readfile(const char *path) {
+	FILE *fp;
+	char *buf;
+	fp = path == NULL ? stdin : fopen(path, "r");
+	if (fp == NULL) {
+		fprintf(stderr, "mocgen: cannot open %s\n", path);
+		exit(1);
+	}
+	buf = readall(fp);
+	if (buf == NULL) {
+		fprintf(stderr, "mocgen: out of memory\n");
+		exit(1);
+	}
+	if (path != NULL) {
+		fclose(fp);
+	}
+	blankout(buf);
+	return buf;
+}
+
+int main(int argc, char *argv[]) {
+	char *buf;
+	int i, first = 1;
+	if (argc > 1 && (strcmp(argv[1], "-w") == 0
+			|| strcmp(argv[1], "-f") == 0
+			|| strcmp(argv[1], "-v") == 0)) {
+		mode = argv[1][1];
+		first = 2;
+	}
+	if (mode != 'f') {
+		out(mode == 'w' ? "/* Linker wrappers generated by mocgen. */\n\n"
+				: mode == 'v' ? "/* Mock vtables generated by mocgen. */\n\n"
+				: "/* Mocks generated by mocgen. */\n\n");
+		for (i = first; i < argc; i++) {
+			out("#include \"");
+			out(argv[i]);
+			out("\"\n");
+		}
+		out("#include \"mocito.h\"\n\n");
+	}
+	if (argc == first) {
+		buf = readfile(NULL);
+		scan(buf);
+		free(buf);
+	}
+	for (i = first; i < argc; i++) {
+		buf = readfile(argv[i]);
+		scan(buf);
+		free(buf);
+	}
+	if (mode == 'f') {
+		out("\n");
+	}
+	return 0;
+}